@@ -20,5 +20,13 @@
 #include "defines.h"
 
 double activation(enum activation_function,double);
+double activation_derivative(enum activation_function, double, double);
+void activation_vector(enum activation_function, enum activation_accuracy, const double *, double *, unsigned int);
+
+void tanh_vector(const double *, double *, size_t, enum activation_accuracy);
+void logistic_vector(const double *, double *, size_t, enum activation_accuracy);
+void softplus_vector(const double *, double *, size_t, enum activation_accuracy);
+void softsign_vector(const double *, double *, size_t, enum activation_accuracy);
+void arctan_vector(const double *, double *, size_t, enum activation_accuracy);
 
 #endif
@@ -0,0 +1,25 @@
+/* backprop.h -- This belongs to gneural_network
+
+   gneural_network is the GNU package which implements a programmable neural network.
+
+   Copyright (C) 2017 gneural_network developers
+
+   This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software
+   Foundation; either version 3, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BACKPROP_H
+#define BACKPROP_H
+
+#include "plan.h"
+
+void plan_backward(const network_plan *, const double *, const double *, const double *, double *, double *,
+                   unsigned int, unsigned int);
+void backprop(const struct nnet *const, const flotype *const, const flotype *const, flotype *const, flotype *const);
+
+#endif
@@ -41,12 +41,25 @@
 // low limit for the genetic algorithm
 #define PAR_QSORT_LOW_LIMIT 1024
 
+// smallest amount of work (elements x cases) worth a parallel region. Opening one costs about as much as a few thousand
+// transfer function evaluations, so smaller loops run inline on the calling thread, or on the team already running it.
+#define PAR_GRAIN 4096
+#define PAR_WORTH(work) ((work) >= PAR_GRAIN && !omp_in_parallel() && omp_get_max_threads() > 1)
+
+// number of training cases evaluated together by a batched forward pass
+#define PLAN_BLOCK_CASES 64
+
 // specifically for datafiles, weights, and activations. We want to be able to compile correctly for different size floats, on account of OMP and GPU
 // restrictions.
 typedef double flotype;
 
-// FLOFMT is for scripts (replace with %#.15g if all bits are needed; FLOFMT3 is for columnar human-readable (output).
+// FLOFMT is for scripts (build with -DFLOFMT_ALL_BITS if all bits are needed); FLOFMT3 is for columnar human-readable
+// (output).
+#ifdef FLOFMT_ALL_BITS
+#define FLOFMT " %#.17g"
+#else
 #define FLOFMT " %#6g"
+#endif
 #define FLOFMT3 " %#6.3g"
 
 #define ZERO ((flotype)0.0)
@@ -56,9 +69,11 @@ typedef double flotype;
 #define absolute(n)    ((flotype)(fabs((double)(n))))
 #define logarithm(n)   ((flotype)(log((double)(n))))
 #define cosine(n)      ((flotype)(cos((double)(n))))
+#define sine(n)        ((flotype)(sin((double)(n))))
 #define hypertan(n)    ((flotype)(tanh((double)(n))))
 #define arctan(n)      ((flotype)(atan((double)(n))))
 #define exponential(n) ((flotype)(exp((double)(n))))
+#define squareroot(n)  ((flotype)(sqrt((double)(n))))
 
 // definition of various internal types
 enum switch_flag {
@@ -79,6 +94,13 @@ enum activation_function {
 	POL2,
 };
 
+// accuracy of the activation functions (see activation_vector)
+enum activation_accuracy {
+	EXACT,   // libm
+	FAST,    // absolute error below 1e-7
+	FASTEST, // absolute error below 1e-4
+};
+
 // accumulators
 enum accumulator_function {
 	LINEAR,
@@ -100,6 +122,26 @@ enum optimization_method {
 	GRADIENT_DESCENT,
 	GENETIC_ALGORITHM,
 	MSMCO,
+	LBFGS,
+	LEVENBERG_MARQUARDT,
+	PARALLEL_TEMPERING,
+	INCREMENTAL_ANNEALING,
+	GENETIC_TOURNAMENT,	// GENETIC_ALGORITHM with its selection spelled out
+};
+
+// update rules of the gradient methods (see optimizer.h)
+enum gradient_optimizer {
+	PLAIN,
+	MOMENTUM,
+	NESTEROV,
+	RMSPROP,
+	ADAM,
+};
+
+// how the gradient methods get the gradient
+enum gradient_type {
+	ANALYTIC,	// by backpropagation (numerically for recurrent networks, which it does not handle)
+	NUMERIC,	// by central differences
 };
 
 // flags for configuration to silence various outputs and warnings. (struct nnet ->flags)
@@ -140,12 +182,24 @@ enum optimization_method {
 #define PLAN_DEPLOY           0x8
 
 #define PLAN_GRAD_DESCENT    0X10
-#define PLAN_ALL_METHODS     (PLAN_GRAD_DESCENT)
+#define PLAN_ALL_METHODS     (PLAN_GRAD_DESCENT | PLAN_HOGWILD)
+#define PLAN_MOMENTUM        0x20
+#define PLAN_NESTEROV        0x40
+#define PLAN_RMSPROP         0x80
+#define PLAN_ADAM           0x100
+#define PLAN_HOGWILD        0x200
+#define PLAN_DETERMINISTIC  0x400
+#define PLAN_ALL_OPTIMIZERS  (PLAN_MOMENTUM | PLAN_NESTEROV | PLAN_RMSPROP | PLAN_ADAM)
 
 #define PLAN_DEFAULT_GOAL     (flotype)0.95
 #define PLAN_DEFAULT_EPOCHS   10
 #define PLAN_DEFAULT_RATE     (flotype)0.01
 #define PLAN_DEFAULT_MAXEP    1000
+#define PLAN_DEFAULT_MOMENTUM (flotype)0.9
+#define PLAN_DEFAULT_DECAY    (flotype)0.999
+
+// added to the root mean square gradient of RMSProp and Adam, so weights with no gradient yet are not divided by zero
+#define OPTIMIZER_EPSILON     1e-8
 
 
 #define MANPAGE "\n"\
@@ -367,6 +421,12 @@ enum optimization_method {
 "       along  with  a Serialize keyword argument, each save will have a new\n"\
 "       incremental serial number.\n"\
 "\n"\
+"       Accuracy commands select how  the  transfer  functions  are  computed.\n"\
+"       Accuracy(Exact),  the  default,  uses  the C library.  Accuracy(Fast)\n"\
+"       and Accuracy(Fastest) use vectorized  approximations  of  the  tanh,\n"\
+"       arctangent,  logistic  and  softplus  functions,  with  an  absolute\n"\
+"       error below 1e-7 and 1e-4 respectively.\n"\
+"\n"\
 "   Node Definition Section\n"\
 "       Node Definition Sections define nodes.  They start with the  keyword\n"\
 "       StartNodes and end with EndNodes.  In between there are CreateInput,\n"\
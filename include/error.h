@@ -18,6 +18,16 @@
 #define ERROR_H
 #include "network.h"
 
+struct _network;         // see network.h
+struct _network_config;
+struct _network_context; // see plan.h
+struct _network_plan;
+
 double error(struct _network *, struct _network_config *);
+double error_context(struct _network_context *, const double *, struct _network_config *);
+double error_gradient(struct _network_context *, const double *, struct _network_config *, double *);
+double error_cached(const struct _network_plan *, const double *, double *, struct _network_config *, const uint32_t *,
+                    unsigned int);
+double error_numeric_gradient(struct _network_context **, int, const double *, struct _network_config *, double, double *);
 
 #endif
@@ -18,7 +18,20 @@
 #define FEEDFORWARD_H
 
 #include <network.h>
+#include "plan.h"
 
 void feedforward(network *);
 
+void plan_forward(const network_plan *, const double *, double *, double *, unsigned int, unsigned int);
+void plan_forward_steps(const network_plan *, const double *, double *, double *, unsigned int, unsigned int,
+                        const uint32_t *, unsigned int);
+void plan_feedforward(network_plan *);
+void context_feedforward(network_context *, const double *);
+
+// length of the history vector fwdprop() records for backprop()
+#define HISTORYSIZE(net) (2 * (size_t)(net)->nodecount + (net)->synapsecount)
+
+void init_activations(const struct nnet *const, flotype *);
+void fwdprop(const struct nnet *const, const flotype *const, flotype *const, flotype *const, flotype *const);
+
 #endif
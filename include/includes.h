@@ -42,5 +42,10 @@
 #include<strings.h>
 #endif
 #include<omp.h>
+#include<sched.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include<sys/types.h>
+#include<sys/wait.h>
 
 #endif
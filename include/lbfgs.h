@@ -0,0 +1,23 @@
+/* lbfgs.h -- This belongs to gneural_network
+
+   gneural_network is the GNU package which implements a programmable neural network.
+
+   Copyright (C) 2017 gneural_network developers
+
+   This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software
+   Foundation; either version 3, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LBFGS_H
+#define LBFGS_H
+
+#include <network.h>
+
+void lbfgs(network *, network_config *);
+
+#endif
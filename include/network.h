@@ -44,6 +44,7 @@ typedef struct _network{
  unsigned int num_of_layers; // total number of layers
  layer *layers;
  neuron *neurons;
+ struct _network_plan *plan; // compiled form of the network (see plan.h); NULL until network_compile is called
 } network;
 
 // struct added by Ray Dillinger, Aug 2016
@@ -56,12 +57,14 @@ struct nnet{
     unsigned int *transferwidths;  // One record per node of how many nodes are to be processed by the transfer fn when
 			           // processing this node.  transfer width is assumed to be one if this is left NULL.
 			           // In wide transfers only the entry corresponding to the first node will be read.
+    enum activation_accuracy accuracy; // accuracy of the transfer functions.  EXACT (zero) unless configured otherwise.
     unsigned int synapsecount;     // this many connections (including bias) are used during one 'cycle' of the network.
     flotype *weights;               // each synapse has its own weight.
     unsigned int *sources;         // each synapse has its own source (bias nodes are source zero).
     unsigned int *dests;           // each synapse has its own destination.
     struct cases *data;
     struct plans *plan;
+    struct nnet_schedule *schedule; // level schedule for parallel fwdprop (see schedule.h); NULL if recurrent or not built.
 };
 
 // struct added by Ray Dillinger, Nov 2016
@@ -82,7 +85,9 @@ struct plans{
     unsigned int batchsize;
     unsigned int epochsize;
     flotype trainrate;
-    flotype momentum;
+    flotype momentum; // decay of the velocity (Momentum, Nesterov) or of the mean gradient (Adam)
+    flotype decay;    // decay of the mean square gradient (RMSProp, Adam)
+    unsigned int workers; // processes sharing out the batches (zero or one: just this one)
 
     char *outputdest; // filename to send individual results to case by case; may be NULL if output is not desired.
     char *reportdest; // filename to send summary report (accuracy, use statistics, time, etc to).
@@ -110,6 +115,7 @@ typedef struct _network_config {
   unsigned char initial_weights_randomization;
   enum optimization_method optimization_type;
   enum error_function error_type;
+  enum activation_accuracy activation_accuracy;
 
   unsigned char load_neural_network;
   char *load_network_file_name;
@@ -126,10 +132,16 @@ typedef struct _network_config {
   double rate;
   int nmax, mmax;
   int npop;
+  int offspring, elite, tournament;
+  int replicas;
   int nxw;
   int maxiter;
+  int memory;
   double accuracy;
   double gamma;
+  enum gradient_optimizer optimizer;
+  double momentum, decay;
+  enum gradient_type gradient;
   double kbtmin, kbtmax;
   double wmin, wmax;
 
@@ -0,0 +1,64 @@
+/* optimizer.h -- This belongs to gneural_network
+
+   gneural_network is the GNU package which implements a programmable neural network.
+
+   Copyright (C) 2017 gneural_network developers
+
+   This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software
+   Foundation; either version 3, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "includes.h"
+
+/*
+ * An optimizer turns gradients into weight updates. With g the gradient and r the rate:
+ *
+ * - PLAIN:    w -= r g
+ * - MOMENTUM: m = momentum m + g;  w -= r m
+ * - NESTEROV: m = momentum m + g;  w -= r (g + momentum m), the gradient taken one velocity step ahead
+ * - RMSPROP:  v = decay v + (1 - decay) g^2;  w -= r g / (sqrt(v) + eps)
+ * - ADAM:     m and v as running means of g (decay 'momentum') and g^2 (decay 'decay'), corrected for starting at zero;
+ *             w -= r m / (sqrt(v) + eps)
+ *
+ * The state is one or two vectors as long as the weight vector, and every update is a single sweep over the weights,
+ * gradient and state together (see simd_momentum_step and simd_adaptive_step), split among the threads when it is long
+ * enough to pay for them.
+ */
+typedef struct _optimizer {
+  enum gradient_optimizer method;
+  unsigned int count;           // number of weights
+  unsigned long steps;          // updates made so far
+  double rate;                  // step size
+  double momentum;              // decay of m
+  double decay;                 // decay of v
+  double *m;                    // velocity, or running mean of the gradient (NULL if the method has none)
+  double *v;                    // running mean of the squared gradient (NULL if the method has none)
+} optimizer;
+
+/*
+ * optimizer_new:
+ * - make an optimizer for 'count' weights, with its state at zero
+ */
+optimizer *optimizer_new(enum gradient_optimizer method, unsigned int count, double rate, double momentum, double decay);
+
+/*
+ * optimizer_step:
+ * - update the weights w[] along the gradient g[], multiplied by 'scale' (to turn a sum over cases into a mean)
+ */
+void optimizer_step(optimizer *, const double *g, double scale, double *w);
+
+/*
+ * optimizer_free:
+ * - release an optimizer
+ */
+void optimizer_free(optimizer *);
+
+#endif
@@ -0,0 +1,120 @@
+/* plan.h -- This belongs to gneural_network
+
+   gneural_network is the GNU package which implements a programmable neural network.
+
+   Copyright (C) 2017 gneural_network developers
+
+   This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software
+   Foundation; either version 3, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PLAN_H
+#define PLAN_H
+
+#include "network.h"
+
+/*
+ * A network_plan is the 'compiled' form of a network: everything feedforward() needs, flattened into index arrays so
+ * that a forward pass is a walk over contiguous memory instead of a chase through neuron and connection pointers.
+ *
+ * - one step per non-input neuron, in evaluation order (layer by layer);
+ * - every weight of every neuron lives in the single vector weights[], in global id order and input order. That is
+ *   the same order the training methods already use for their flat weight index 'k', and once a network is compiled
+ *   each neuron's 'w' points into this vector, so writing nn->neurons[i].w[j] writes the plan.
+ * - source[] runs parallel to weights[] and gives the global id of the neuron feeding each weight, so the inputs of a
+ *   step are source[first[step]] .. source[first[step] + fanin[step] - 1];
+ * - act[] holds one output per neuron (indexed by global id).
+ * - batch[] holds the outputs of a block of up to PLAN_BLOCK_CASES training cases as a [neuron x case] matrix: the
+ *   output of neuron g for case c is batch[g * PLAN_BLOCK_CASES + c]. act[] is the same layout with one case.
+ * - legendre[] and laguerre[] are the polynomial coefficients of the LEGENDRE and LAGUERRE accumulators: the
+ *   polynomial applied to input i of a step has degree i and its coefficient of x^j is table[i * (i + 1) / 2 + j]
+ *   (a triangular table, one row per input position up to the largest fan-in). The 2^i factor of LEGENDRE is folded
+ *   into its coefficients.
+ * - a plan is 'recurrent' when some step reads a neuron that is not evaluated before it. Such a step reads the value
+ *   left over by the previous case, so the cases of a recurrent plan have to be evaluated one at a time.
+ *
+ * A plan is built once, after the topology is final (see network_compile), and is released by network_free.
+ */
+typedef struct _network_plan {
+  unsigned int num_of_neurons;  // size of act[] (one slot per global id)
+  unsigned int num_of_steps;    // number of neurons evaluated by a forward pass
+  unsigned int weight_count;    // total number of weights in the network
+  unsigned int num_of_inputs;   // neurons of the first layer
+  unsigned int num_of_outputs;  // neurons of the last layer
+  int recurrent;                // some step reads a neuron evaluated after it (or itself)
+  enum activation_accuracy accuracy; // accuracy of the activation functions (EXACT unless the script asks otherwise)
+
+  uint32_t *neuron;             // global id of the neuron evaluated at each step
+  uint32_t *first;              // index into source[] and weights[] of the first input of each step
+  uint32_t *fanin;              // number of inputs of each step
+  unsigned char *activation;    // activation function of each step
+  unsigned char *accumulator;   // accumulator function of each step
+  uint32_t *source;             // global id of the neuron feeding each weight
+
+  uint32_t *input;              // global ids of the input neurons
+  uint32_t *output;             // global ids of the output neurons
+
+  double *weights;              // all the weights of the network
+  double *act;                  // neuron outputs, indexed by global id
+  double *batch;                // neuron outputs for a block of cases, [neuron x PLAN_BLOCK_CASES]
+
+  unsigned int max_fanin;       // rows of the polynomial tables
+  double *legendre;             // LEGENDRE coefficients, triangular
+  double *laguerre;             // LAGUERRE coefficients, triangular
+} network_plan;
+
+/*
+ * A network_context holds the activation state of one evaluation of a compiled network: act[] and batch[], laid out
+ * as in the plan, plus what the backward pass of error_gradient needs. The plan itself (weights included) is only read by plan_forward, so any number of threads can
+ * evaluate the same network at once, each through its own context and, if it likes, its own weight vector in the
+ * layout of plan->weights. The plan's own act[] and batch[] are the context of the single threaded calls,
+ * feedforward() and error().
+ *
+ * A context made for a plan is only good for that plan: recompiling the network invalidates it.
+ */
+typedef struct _network_context {
+  const network_plan *plan;     // the plan evaluated
+  double *act;                  // neuron outputs for one case, indexed by global id
+  double *batch;                // neuron outputs for a block of cases, [neuron x PLAN_BLOCK_CASES]
+  double *pre;                  // accumulated inputs for the backward pass, laid out like batch
+  double *delta;                // derivatives of the error by the neuron outputs, laid out like batch
+} network_context;
+
+/*
+ * network_compile:
+ * - build (or rebuild) the plan of a network. The weights are moved into the plan.
+ */
+network_plan *network_compile(network *);
+
+/*
+ * network_plan_free:
+ * - release a plan. Only network_free should call this on the plan of a live network.
+ */
+void network_plan_free(network_plan *);
+
+/*
+ * network_context_new:
+ * - make an evaluation context for a network, compiling it if needed. act[] starts as a copy of the plan's, so a
+ *   recurrent network starts from the same state in every context.
+ */
+network_context *network_context_new(network *);
+
+/*
+ * network_context_reset:
+ * - put the state of a recurrent network in a context back to the plan's, so that the next evaluation starts from the
+ *   state of the network and not from the one left by the evaluation before. Does nothing for other networks.
+ */
+void network_context_reset(network_context *);
+
+/*
+ * network_context_free:
+ * - release a context.
+ */
+void network_context_free(network_context *);
+
+#endif
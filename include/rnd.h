@@ -17,5 +17,7 @@
 #define RND_H
 
 double rnd(void);
+double rnd_r(unsigned int *);
+unsigned int rnd_seed(unsigned int);
 
 #endif
@@ -0,0 +1,63 @@
+/* schedule.h -- This belongs to gneural_network
+
+   gneural_network is the GNU package which implements a programmable neural network.
+
+   Copyright (C) 2017 gneural_network developers
+
+   This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software
+   Foundation; either version 3, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include "network.h"
+
+/*
+ * A level schedule lets fwdprop() evaluate a feedforward nnet level by level instead of synapse by synapse.
+ *
+ * - nodes are handled in transfer groups: a group starts at a node whose transfer function fires (every node, unless a
+ *   wide transfer covers several) and spans transferwidths[] nodes. Node zero, the bias, belongs to no group.
+ * - the level of a group is one more than the highest level among the groups feeding it; groups fed by nothing but the
+ *   bias and the inputs are level zero. The groups of one level never feed each other, so they can be evaluated in
+ *   any order, or all at once.
+ * - groups[] lists the first node of every group, level after level: level l is groups[levels[l]] .. groups[levels[l+1]-1].
+ * - the synapses are also kept ordered by destination (compressed sparse rows), keeping the script order among the
+ *   synapses of one destination, which is the order fwdprop combines them in: node n receives the synapses at
+ *   positions first[n] .. first[n+1]-1 of sources[] and weights[], so a node gathers all its inputs from contiguous
+ *   memory and writes its activation once. synapses[] maps each position back to the index of the synapse in the
+ *   network; weights[] is a copy, so whatever changes net->weights must call nnet_schedule_weights() before the next
+ *   fwdprop().
+ *
+ * fwdprop() fires nodes as the synapse list reaches their outputs, so a synapse into a node that has already fired
+ * carries its signal over to the next activation sequence. A schedule is only built when no synapse does that, which
+ * makes the levelled evaluation give the same activations as the sequential one.
+ */
+struct nnet_schedule{
+    unsigned int levelcount;   // number of levels
+    unsigned int groupcount;   // number of transfer groups
+    unsigned int widest;       // number of synapses plus nodes in the biggest level
+    unsigned int *levels;      // levelcount + 1 offsets into groups[]
+    unsigned int *groups;      // first node of each transfer group, level by level
+    unsigned int *work;        // number of synapses plus nodes of each level
+    unsigned int *first;       // nodecount + 1 offsets into the arrays below
+    unsigned int *synapses;    // index in the network of each synapse, ordered by destination
+    unsigned int *sources;     // source node of each synapse, ordered by destination
+    flotype *weights;          // weight of each synapse, ordered by destination
+};
+
+// build the level schedule of a parsed network; returns NULL when the network is recurrent (see above)
+struct nnet_schedule *nnet_schedule(const struct nnet *net);
+
+// copy the weights of a network into its schedule, after training or anything else has changed them
+void nnet_schedule_weights(const struct nnet *net);
+
+// release a schedule built by nnet_schedule()
+void nnet_schedule_free(struct nnet_schedule *sched);
+
+#endif
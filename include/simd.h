@@ -0,0 +1,50 @@
+/* simd.h -- This belongs to gneural_network
+
+   gneural_network is the GNU package which implements a programmable neural network.
+
+   Copyright (C) 2017 gneural_network developers
+
+   This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software
+   Foundation; either version 3, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIMD_H
+#define SIMD_H
+
+#include "includes.h"
+
+/*
+ * Vector kernels shared by both engines. Every kernel exists in a scalar, SSE2, AVX2 (with FMA) and AVX-512 version;
+ * simd_init() points the function pointers below at the best version the CPU supports. Until simd_init() is called
+ * they point at the scalar versions, so calling them early is safe, only slower.
+ *
+ * The vector versions add in a different order than the scalar ones, so results may differ in the last bits from one
+ * CPU to another.
+ */
+
+// returns the sum of w[i] * x[idx[i]] for i in 0 .. n-1
+extern double (*simd_dot_gather)(unsigned int n, const double *w, const double *x, const uint32_t *idx);
+
+// y[i] += a * x[i] for i in 0 .. n-1
+extern void (*simd_axpy)(unsigned int n, double a, const double *x, double *y);
+
+// weight update of the momentum methods, for i in 0 .. n-1 with gi = scale * g[i]:
+//   m[i] = mu * m[i] + gi;  w[i] -= a * gi + b * m[i]
+extern void (*simd_momentum_step)(unsigned int n, const double *g, double scale, double mu, double a, double b, double *m,
+                                  double *w);
+
+// weight update of the adaptive methods, for i in 0 .. n-1 with gi = scale * g[i]:
+//   m[i] = beta1 * m[i] + (1 - beta1) * gi;  v[i] = beta2 * v[i] + (1 - beta2) * gi * gi;
+//   w[i] -= (a * gi + b * m[i]) / (sqrt(v[i]) + eps)
+extern void (*simd_adaptive_step)(unsigned int n, const double *g, double scale, double beta1, double beta2, double a,
+                                  double b, double eps, double *m, double *v, double *w);
+
+// select the kernels for the running CPU; returns the name of the instruction set in use
+const char *simd_init(void);
+
+#endif
@@ -19,5 +19,7 @@
 #include <network.h>
 
 void simulated_annealing(network *, network_config*);
+void parallel_tempering(network *, network_config*);
+void incremental_annealing(network *, network_config*);
 
 #endif
@@ -0,0 +1,31 @@
+/* train.h -- This belongs to gneural_network
+
+   gneural_network is the GNU package which implements a programmable neural network.
+
+   Copyright (C) 2017 gneural_network developers
+
+   This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software
+   Foundation; either version 3, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRAIN_H
+#define TRAIN_H
+
+#include "network.h"
+
+struct workers; // see workers.h
+
+// train a network according to one training plan, on the cases of its Training data statements; returns the accuracy
+// (one minus the root mean square error of the outputs) over the last epoch. A plan with Workers or Deterministic is
+// shared out among 'group', the worker processes runplans started (NULL: this process alone).
+flotype nnettrain(struct nnet *net, const struct plans *plan, struct workers *group);
+
+// carry out the plans of a parsed script, in script order
+void runplans(struct nnet *net);
+
+#endif
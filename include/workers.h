@@ -0,0 +1,55 @@
+/* workers.h -- This belongs to gneural_network
+
+   gneural_network is the GNU package which implements a programmable neural network.
+
+   Copyright (C) 2017 gneural_network developers
+
+   This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software
+   Foundation; either version 3, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef WORKERS_H
+#define WORKERS_H
+
+#include "includes.h"
+
+// A group of worker processes forked from one process on the same host, sharing a block of memory and a barrier, so
+// that they can sum their gradients without MPI or any other runtime. Worker 0 is the process that started the group;
+// it hands the others jobs (see workers_post), and the first 'active' workers take part in each.
+struct workers{
+    int count;           // number of processes, the starting one included
+    int active;          // how many of them (the first ones) take part in the current job
+    int rank;            // which of them this is
+    pid_t *pids;         // process ids of the workers; the others only know the one of worker 0
+    size_t size;         // bytes of the shared mapping
+    void *mapping;       // the barriers and the job, then the data
+};
+
+// fork count - 1 workers, all sharing 'bytes' bytes of zeroed memory. Returns in every worker. A process that has run
+// an OpenMP parallel region has a pool of threads its children do not get, and a child hangs in its first parallel
+// region: start the group before any.
+struct workers *workers_start(int count, size_t bytes);
+
+// the shared data, the same in every worker
+void *workers_data(const struct workers *w);
+
+// worker 0: hand the next job, a positive number, to the first 'active' workers (worker 0 included). Memory written
+// before the call is seen by all of them after.
+void workers_post(struct workers *w, int job, int active);
+
+// the other workers: wait for the next job they take part in, and return it; zero when the group ends.
+int workers_next(struct workers *w);
+
+// wait until every worker of the current job has reached the barrier. Memory written before it by any of them is seen
+// after it by all.
+void workers_barrier(struct workers *w);
+
+// end the group: workers other than 0 exit here; worker 0 tells them to, waits for them and releases the shared memory.
+void workers_finish(struct workers *w);
+
+#endif
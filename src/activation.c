@@ -34,7 +34,7 @@ inline double activation(enum activation_function type,double x){
    return 2./(1. + exp(-x)) - 1.;
    break;
   case SOFTSIGN:   // scaled from -1 to 1
-   return x / abs(x)+1;
+   return x / (1. + fabs(x));
    break;
   case RAMP:
    return (x > 0.) ? x : 0.;
@@ -54,3 +54,230 @@ inline double activation(enum activation_function type,double x){
  }
 }
 
+
+// returns the derivative of the specified activation function at x, given y = activation(type, x) as well: most of them
+// are cheapest in terms of their own value
+double activation_derivative(enum activation_function type, double x, double y){
+ switch (type) {
+  case TANH:
+   return 1. - y * y;
+   break;
+  case EXP:
+   return y * (1. - y);
+   break;
+  case ID:
+   return 1.;
+   break;
+  case EXP_SIGNED:
+   return 0.5 * (1. + y) * (1. - y);
+   break;
+  case SOFTSIGN:
+   return 1. / ((1. + fabs(x)) * (1. + fabs(x)));
+   break;
+  case RAMP:
+   return (x > 0.) ? 1. : 0.;
+   break;
+  case SOFTRAMP: // the logistic function, 1 - exp(-y) since y = log(1 + exp(x))
+   return -expm1(-y);
+   break;
+  case POL1:
+   return 1.;
+   break;
+  case POL2:
+   return 1. + 2. * x;
+   break;
+  default:
+   printf("unknown activation function!\n");
+   exit(-1);
+ }
+}
+
+
+/*
+ * Vectorized activation functions. In EXACT mode they compute the same libm expressions as activation() and
+ * transfer(). The FAST and FASTEST modes replace exp, log and atan by polynomials after range reduction, written
+ * without branches so that the loops vectorize; their absolute error is below 1e-7 (FAST) or 1e-4 (FASTEST).
+ * Every kernel is compiled for AVX-512, AVX2 and the baseline instruction set, and the loader picks the best one.
+ */
+
+// The range clamps would keep GCC from vectorizing the loops without AVX-512 masks unless floating point operations
+// are allowed to be speculated. Nothing in gneural_network inspects the floating point exception flags.
+#if defined(__x86_64__) && defined(__GNUC__)
+#define VECTOR_CLONES __attribute__((target_clones("avx512f","avx2","default"), optimize("no-trapping-math")))
+#else
+#define VECTOR_CLONES
+#endif
+
+// the kernels below are always inlined with a constant accuracy, so that the accuracy tests vanish from the loops
+#if defined(__GNUC__)
+#define KERNEL static inline __attribute__((always_inline, optimize("no-trapping-math")))
+#else
+#define KERNEL static inline
+#endif
+
+#define LOG2E   1.4426950408889634
+#define LN2_HI  6.93147180369123816490e-01
+#define LN2_LO  1.90821492927058770002e-10
+#define SHIFTER 6755399441055744.0    // 1.5 * 2^52: adding it rounds to an integer kept in the low mantissa bits
+
+// exp(x) for x <= 0: x = n ln2 + r with |r| <= ln2/2, exp(r) by its Taylor polynomial, 2^n built in the exponent bits
+KERNEL double fast_exp_neg(double x, const enum activation_accuracy acc){
+ double t, n, r, p, scale;
+ int64_t bits;
+
+ x = x < -708. ? -708. : x;
+ t = x * LOG2E + SHIFTER;
+ n = t - SHIFTER;
+ r = (x - n * LN2_HI) - n * LN2_LO;
+ if (acc == FASTEST)
+  p = 1. + r * (1. + r * (1./2 + r * (1./6 + r * (1./24))));
+ else
+  p = 1. + r * (1. + r * (1./2 + r * (1./6 + r * (1./24 + r * (1./120 + r * (1./720 + r * (1./5040)))))));
+ memcpy(&bits, &t, sizeof(bits));
+ bits = (bits - 0x4338000000000000LL + 1023) << 52;
+ memcpy(&scale, &bits, sizeof(scale));
+ return p * scale;
+}
+
+// log(1 + u) for 0 <= u <= 1, from the series of 2 atanh(t) with t = u / (2 + u) <= 1/3
+KERNEL double fast_log1p_unit(double u, const enum activation_accuracy acc){
+ double t = u / (2. + u);
+ double t2 = t * t;
+ if (acc == FASTEST)
+  return 2. * t * (1. + t2 * (1./3 + t2 * (1./5 + t2 * (1./7))));
+ return 2. * t * (1. + t2 * (1./3 + t2 * (1./5 + t2 * (1./7 + t2 * (1./9 + t2 * (1./11 + t2 * (1./13)))))));
+}
+
+// atan(a) for a >= 0: a > 1 is reflected to 1/a, a > tan(PI/8) is shifted by PI/4, then the Taylor series is used
+KERNEL double fast_atan(double x, const enum activation_accuracy acc){
+ double a = fabs(x);
+ double z = a > 1. ? 1. / a : a;
+ double u = z > 0.41421356237309503 ? (z - 1.) / (z + 1.) : z;
+ double u2 = u * u, r;
+ if (acc == FASTEST)
+  r = u * (1. - u2 * (1./3 - u2 * (1./5 - u2 * (1./7))));
+ else
+  r = u * (1. - u2 * (1./3 - u2 * (1./5 - u2 * (1./7 - u2 * (1./9 - u2 * (1./11 - u2 * (1./13 - u2 * (1./15))))))));
+ r = z > 0.41421356237309503 ? M_PI_4 + r : r;
+ r = a > 1. ? M_PI_2 - r : r;
+ return copysign(r, x);
+}
+
+KERNEL void tanh_kernel(const double *x, double *y, size_t n, const enum activation_accuracy acc){
+ size_t i;
+#pragma omp simd
+ for (i = 0; i < n; i++) {
+  double e = fast_exp_neg(-2. * fabs(x[i]), acc);
+  y[i] = copysign((1. - e) / (1. + e), x[i]);
+ }
+}
+
+KERNEL void logistic_kernel(const double *x, double *y, size_t n, const enum activation_accuracy acc){
+ size_t i;
+#pragma omp simd
+ for (i = 0; i < n; i++) {
+  double e = fast_exp_neg(-fabs(x[i]), acc);
+  double p = 1. / (1. + e);
+  y[i] = x[i] >= 0. ? p : e * p;
+ }
+}
+
+KERNEL void softplus_kernel(const double *x, double *y, size_t n, const enum activation_accuracy acc){
+ size_t i;
+#pragma omp simd
+ for (i = 0; i < n; i++)
+  y[i] = (x[i] > 0. ? x[i] : 0.) + fast_log1p_unit(fast_exp_neg(-fabs(x[i]), acc), acc);
+}
+
+KERNEL void arctan_kernel(const double *x, double *y, size_t n, const enum activation_accuracy acc){
+ size_t i;
+#pragma omp simd
+ for (i = 0; i < n; i++)
+  y[i] = fast_atan(x[i], acc);
+}
+
+VECTOR_CLONES
+void tanh_vector(const double *x, double *y, size_t n, enum activation_accuracy acc){
+ size_t i;
+ if (acc == FASTEST)
+  tanh_kernel(x, y, n, FASTEST);
+ else if (acc == FAST)
+  tanh_kernel(x, y, n, FAST);
+ else
+  for (i = 0; i < n; i++)
+   y[i] = tanh(x[i]);
+}
+
+VECTOR_CLONES
+void logistic_vector(const double *x, double *y, size_t n, enum activation_accuracy acc){
+ size_t i;
+ if (acc == FASTEST)
+  logistic_kernel(x, y, n, FASTEST);
+ else if (acc == FAST)
+  logistic_kernel(x, y, n, FAST);
+ else
+  for (i = 0; i < n; i++)
+   y[i] = 1. / (1. + exp(-x[i]));
+}
+
+VECTOR_CLONES
+void softplus_vector(const double *x, double *y, size_t n, enum activation_accuracy acc){
+ size_t i;
+ if (acc == FASTEST)
+  softplus_kernel(x, y, n, FASTEST);
+ else if (acc == FAST)
+  softplus_kernel(x, y, n, FAST);
+ else
+  for (i = 0; i < n; i++)
+   y[i] = log(1. + exp(x[i]));
+}
+
+// softsign needs no approximation: every accuracy gets the exact formula
+VECTOR_CLONES
+void softsign_vector(const double *x, double *y, size_t n, enum activation_accuracy acc){
+ size_t i;
+#pragma omp simd
+ for (i = 0; i < n; i++)
+  y[i] = x[i] / (1. + fabs(x[i]));
+}
+
+VECTOR_CLONES
+void arctan_vector(const double *x, double *y, size_t n, enum activation_accuracy acc){
+ size_t i;
+ if (acc == FASTEST)
+  arctan_kernel(x, y, n, FASTEST);
+ else if (acc == FAST)
+  arctan_kernel(x, y, n, FAST);
+ else
+  for (i = 0; i < n; i++)
+   y[i] = atan(x[i]);
+}
+
+// y[i] = activation(type, x[i]) for i in 0 .. n-1, at the given accuracy
+void activation_vector(enum activation_function type, enum activation_accuracy acc, const double *x, double *y,
+                       unsigned int n){
+ unsigned int i;
+ switch (type) {
+  case TANH:
+   tanh_vector(x, y, n, acc);
+   break;
+  case EXP:
+   logistic_vector(x, y, n, acc);
+   break;
+  case EXP_SIGNED:
+   logistic_vector(x, y, n, acc);
+   for (i = 0; i < n; i++)
+    y[i] = 2. * y[i] - 1.;
+   break;
+  case SOFTSIGN:
+   softsign_vector(x, y, n, acc);
+   break;
+  case SOFTRAMP:
+   softplus_vector(x, y, n, acc);
+   break;
+  default:
+   for (i = 0; i < n; i++)
+    y[i] = activation(type, x[i]);
+   break;
+ }
+}
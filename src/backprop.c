@@ -0,0 +1,223 @@
+/* backprop.c -- This belongs to gneural_network
+
+   gneural_network is the GNU package which implements a programmable neural network.
+
+   Copyright (C) 2017 gneural_network developers
+
+   This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software
+   Foundation; either version 3, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// backward propagation of the error derivatives: through a compiled network (reverse mode differentiation of
+// plan_forward) and through the synapse sequence of an nnet (reverse mode differentiation of fwdprop)
+
+#include "includes.h"
+#include "backprop.h"
+#include "activation.h"
+
+#define PI M_PI
+
+// the term input i of a step contributes to the step's accumulated input is w[i] * f(a), where f depends on the
+// accumulator and on i. Compute f(a) and f'(a) for ncases values of a, the same way plan_forward computes f(a).
+static void accumulator_terms(const network_plan *plan, unsigned char accumulator, unsigned int i, const double *a,
+                              unsigned int ncases, double *f, double *df){
+ register unsigned int j;
+ unsigned int c;
+ double p, dp, tmp;
+
+ switch (accumulator) {
+  case LINEAR:
+   for (c = 0; c < ncases; c++) {
+    f[c] = a[c];
+    df[c] = 1.;
+   }
+   break;
+  case LEGENDRE:
+  case LAGUERRE: {
+   const double *table = (accumulator == LEGENDRE) ? plan->legendre : plan->laguerre;
+   const double *coef = &table[i * (i + 1) / 2]; // degree i polynomial (see plan.h)
+   for (c = 0; c < ncases; c++) {
+    // Horner's scheme, carrying the derivative along
+    for (p = coef[i], dp = 0., j = i; j > 0; j--) {
+     dp = dp * a[c] + p;
+     p = p * a[c] + coef[j - 1];
+    }
+    f[c] = p;
+    df[c] = dp;
+   }
+  }
+   break;
+  case FOURIER:
+   // f(a) is the sum of sin(2 PI j a) and f'(a) the sum of 2 PI j cos(2 PI j a) for j = 1 .. i, with the harmonics
+   // built by the angle addition formulas as in plan_forward
+   for (c = 0; c < ncases; c++) {
+    double sin1 = sin(2. * PI * a[c]), cos1 = cos(2. * PI * a[c]);
+    double sinj = sin1, cosj = cos1;
+    f[c] = df[c] = 0.;
+    for (j = 1; j <= i; j++) {
+     f[c] += sinj;
+     df[c] += 2. * PI * j * cosj;
+     tmp = sinj * cos1 + cosj * sin1;
+     cosj = cosj * cos1 - sinj * sin1;
+     sinj = tmp;
+    }
+   }
+   break;
+  default:
+   for (c = 0; c < ncases; c++)
+    f[c] = df[c] = 0.;
+   break;
+ }
+}
+
+// walk the steps of a compiled network backwards for ncases cases. act and pre are the outputs and accumulated inputs
+// of a plan_forward call with the same weights, delta holds the derivatives of the error by the neuron outputs (only
+// the rows of the outputs need to be set; the others must be zero) and gets the derivatives by every other neuron
+// output added to it. The derivatives by the weights, summed over the cases, are added to grad[]. All matrices have the
+// [neuron x case] layout with a row stride of 'stride' cases.
+//
+// A recurrent plan reads values left over from the previous case, which this does not follow: only call it on plans
+// that are not recurrent.
+void plan_backward(const network_plan *plan, const double *weights, const double *act, const double *pre,
+                   double *delta, double *grad, unsigned int stride, unsigned int ncases){
+ register unsigned int i;
+ unsigned int s, c;
+ double d[PLAN_BLOCK_CASES], f[PLAN_BLOCK_CASES], df[PLAN_BLOCK_CASES];
+ double sum;
+
+ for (s = plan->num_of_steps; s-- > 0;) {
+  const unsigned int g = plan->neuron[s];
+  const unsigned int first = plan->first[s];
+
+  // derivative of the error by the accumulated input of the step
+  for (c = 0; c < ncases; c++)
+   d[c] = delta[g * stride + c] * activation_derivative(plan->activation[s], pre[g * stride + c], act[g * stride + c]);
+
+  for (i = 0; i < plan->fanin[s]; i++) {
+   const unsigned int src = plan->source[first + i];
+   accumulator_terms(plan, plan->accumulator[s], i, &act[src * stride], ncases, f, df);
+   for (sum = 0., c = 0; c < ncases; c++) {
+    sum += d[c] * f[c];
+    delta[src * stride + c] += d[c] * weights[first + i] * df[c];
+   }
+   grad[first + i] += sum;
+  }
+ }
+}
+
+
+// derivatives of the transfer functions of transfer(): given the inputs (ins) and outputs (outs) of a transfer group of
+// 'width' nodes and the derivatives of the error by its outputs (douts), store the derivatives by its inputs in dins.
+static void transfer_backward(int fchoice, const flotype *ins, const flotype *outs, const flotype *douts, flotype *dins,
+			      size_t width){
+    size_t count;
+    switch(fchoice){
+    case 0: for (count = 0; count < width; count++) dins[count] = douts[count]; break; // identity
+    case 1: for (count = 0; count < width; count++) dins[count] = douts[count] * (ONE - outs[count] * outs[count]); break;
+    case 2: for (count = 0; count < width; count++) dins[count] = douts[count] / (ONE + ins[count] * ins[count]); break;
+    case 3: for (count = 0; count < width; count++) dins[count] = douts[count] * outs[count] * (ONE - outs[count]); break;
+    case 4: for (count = 0; count < width; count++) dins[count] = douts[count] * (ONE - outs[count] * outs[count]) / TWO; break;
+    case 5:
+	for (count = 0; count < width; count++)
+	    dins[count] = douts[count] / ((ONE + absolute(ins[count])) * (ONE + absolute(ins[count])));
+	break;
+    case 6: // log|x+1| on both sides, negated for x <= 0
+	for (count = 0; count < width; count++)
+	    dins[count] = douts[count] * (ins[count] > ZERO ? ONE : -ONE) / (ins[count] + ONE);
+	break;
+    case 7: for (count = 0; count < width; count++) dins[count] = ZERO; break; // step
+    case 8: for (count = 0; count < width; count++) dins[count] = ins[count] > ZERO ? douts[count] : ZERO; break;
+    case 9: for (count = 0; count < width; count++) dins[count] = -douts[count] * expm1(-outs[count]); break; // logistic(x)
+    case 10: for (count = 0; count < width; count++) dins[count] = ins[count] >= ONE ? douts[count] / ins[count] : ZERO; break;
+    case 11: for (count = 0; count < width; count++) dins[count] = -douts[count] * sine(ins[count]); break;
+    case 12: for (count = 0; count < width; count++) dins[count] = -TWO * ins[count] * outs[count] * douts[count]; break;
+    case 13:
+	for (count = 0; count < width; count++)
+	    dins[count] = douts[count] * (TWO * ins[count] * logarithm(ins[count]) + ins[count]);
+	break;
+    case 14: // outs[count] = ins[count] * ins[0] for count >= 1, outs[0] = 0
+	dins[0] = ZERO;
+	for (count = 1; count < width; count++){
+	    dins[count] = douts[count] * ins[0];
+	    dins[0] += douts[count] * ins[count];
+	} break;
+    case 15: // pairwise product and sum; an odd last node is not written by transfer()
+	for (count = 0; count + 1 < width; count += 2){
+	    dins[count] = douts[count] * ins[count + 1] + douts[count + 1];
+	    dins[count + 1] = douts[count] * ins[count] + douts[count + 1];
+	}
+	if (width % 2) dins[width - 1] = ZERO;
+	break;
+    default: fprintf(stderr, "unknown transfer function\n"); exit(1);
+    }
+}
+
+// backprop: reverse mode differentiation of one fwdprop() call. history is the history that call recorded, outerr the
+// derivatives of the error by the outputs of the network (net->outputcount values). The derivative of the error by the
+// weight of every synapse is added to gradient (net->synapsecount values), so the gradients of several cases can be
+// summed by calling this once per case. delta is scratch space for 2 * nodecount values; on return its first half holds
+// the derivatives of the error by the output of every node, and the second half those by their activation levels.
+
+// The synapse sequence is walked backwards, undoing fwdprop's firings at the points where fwdprop performed them. A
+// synapse into a node that had already fired feeds the next activation sequence, not this one, so in recurrent networks
+// the derivatives stop at the boundary of the activation sequence (truncated backpropagation through time).
+
+void backprop(const struct nnet *const net, const flotype *const history, const flotype *const outerr,
+	      flotype *const delta, flotype *const gradient){
+    const flotype *const res = history;
+    const flotype *const pre = &(history[net->nodecount]);
+    const flotype *const before = &(history[2 * net->nodecount]);
+    flotype *const dres = delta;
+    flotype *const dacc = &(delta[net->nodecount]);
+    // the transfer groups in firing order, and the synapse each fires before (synapsecount if after the last one)
+    unsigned int *groups = alloca(sizeof(unsigned int) * net->nodecount);
+    unsigned int *reach = alloca(sizeof(unsigned int) * net->nodecount);
+    size_t groupcount = 0, nodecount = 1, wcount;
+    long gcount;
+
+    for (wcount = 0; wcount < net->synapsecount; wcount++)
+	for (; nodecount <= net->sources[wcount]; nodecount += net->transferwidths[nodecount]){
+	    groups[groupcount] = nodecount; reach[groupcount++] = wcount;
+	}
+    for (; nodecount < net->nodecount; nodecount += net->transferwidths[nodecount]){
+	groups[groupcount] = nodecount; reach[groupcount++] = net->synapsecount;
+    }
+
+    memset(delta, 0, sizeof(flotype) * 2 * net->nodecount);
+    for (size_t count = 0; count < net->outputcount; count++) dres[net->nodecount - net->outputcount + count] = outerr[count];
+
+    gcount = (long)groupcount - 1;
+    for (wcount = net->synapsecount + 1; wcount-- > 0; ){
+	// undo the firings that happened before this synapse (or after the last one), latest first
+	for (; gcount >= 0 && reach[gcount] == wcount; gcount--){
+	    const unsigned int group = groups[gcount];
+	    transfer_backward(net->transfer[group], &(pre[group]), &(res[group]), &(dres[group]), &(dacc[group]),
+			      net->transferwidths[group]);
+	}
+	if (wcount == 0) break;
+	// synapse wcount-1, if its destination had not fired yet (every group from gcount down has fired)
+	const size_t syn = wcount - 1;
+	const unsigned int dest = net->dests[syn], src = net->sources[syn];
+	if (dest == 0 || (gcount >= 0 && dest < groups[gcount] + net->transferwidths[groups[gcount]])) continue;
+	const flotype ad = res[src] * net->weights[syn];
+	flotype dad;
+	switch(net->accum[dest]){
+	case 0: dad = ZERO; break;
+	case 1: dad = dacc[dest]; break;
+	case 2: dad = dacc[dest] * before[syn]; dacc[dest] *= ad; break;
+	case 3: dad = dacc[dest] / ((ONE + absolute(ad)) * (ONE + absolute(ad))); break;
+	case 4: dad = ad > ZERO ? dacc[dest] : (ad < ZERO ? -dacc[dest] : ZERO); break;
+	case 5: dad = dacc[dest] / (absolute(ad) + ONE); break;
+	case 6: if (before[syn] > ad) dad = ZERO; else {dad = dacc[dest]; dacc[dest] = ZERO;} break;
+	case 7: dad = ad > ZERO ? dacc[dest] : ZERO; break;
+	default: fprintf(stderr, "unknown combination function\n"); exit(1);
+	}
+	gradient[syn] += dad * res[src];
+	dres[src] += dad * net->weights[syn];
+    }
+}
@@ -18,71 +18,230 @@
 
 #include "includes.h"
 #include "feedforward.h"
+#include "plan.h"
+#include "backprop.h"
 
-double error(network *nn, network_config *config){
+// copy the inputs of the training cases n .. n+ncases-1 into the [neuron x case] matrix act (see plan.h)
+static inline void load_cases(const network_plan *plan, network_config *config, double *act, unsigned int stride,
+                              int n, unsigned int ncases){
+ unsigned int i, c;
+ for (i = 0; i < plan->num_of_inputs; i++) {
+  const uint32_t g = plan->input[i];
+  for (c = 0; c < ncases; c++)
+   act[g * stride + c] = config->cases_x[n + c][g][0];
+ }
+}
+
+// add the error of the training cases n .. n+ncases-1 to err, one case after the other
+static inline double add_case_errors(const network_plan *plan, network_config *config, const double *act,
+                                     unsigned int stride, int n, unsigned int ncases, double err){
+ unsigned int j, c;
+ double tmp[PLAN_BLOCK_CASES];
+ double y;
+
+ for (c = 0; c < ncases; c++)
+  tmp[c] = 0.;
+
+ for (j = 0; j < plan->num_of_outputs; j++) {
+  const uint32_t g = plan->output[j];
+  for (c = 0; c < ncases; c++) {
+   y = act[g * stride + c];
+   if (config->error_type == ME)
+    // compute the mean error comparing with training output
+    tmp[c] += fabs(y - config->cases_y[n + c][g]);
+   else
+    // compute the squared error comparing with the training output
+    tmp[c] += (y - config->cases_y[n + c][g]) * (y - config->cases_y[n + c][g]);
+  }
+ }
+
+ for (c = 0; c < ncases; c++)
+  err += tmp[c];
+ return err;
+}
+
+// the training cases are evaluated a block at a time by a batched forward pass, in batch. A recurrent plan carries
+// state from one case to the next, so its cases are evaluated one at a time in act.
+static double plan_error(const network_plan *plan, const double *w, double *act, double *batch, network_config *config){
+ unsigned int block = plan->recurrent ? 1 : PLAN_BLOCK_CASES;
+ unsigned int nb;
  register int n;
  double err;
- double y;
+
+ if (config->error_type != ME && config->error_type != MSE)
+  return 0.;
+
+ if (!plan->recurrent)
+  act = batch;
 
  err = 0.;
+ for (n = 0; n < config->num_cases; n += nb) {
+  nb = MIN(block, config->num_cases - n);
+  load_cases(plan, config, act, block, n, nb);
+  plan_forward(plan, w, act, NULL, block, nb);
+  err = add_case_errors(plan, config, act, block, n, nb, err);
+ }
 
  switch (config->error_type) {
  // Mean Error
  case ME:
-   err = -1.e8;
-   for (n = 0; n < config->num_cases; n++) {
-    int i, j;
-    // assign training input
-    for (i = 0; i < nn->layers[0].num_of_neurons; i++) {
-     neuron *ne = &nn->layers[0].neurons[i];
-#if 1
-     ne->output = config->cases_x[n][ne->global_id][0];
-#else
-     for (j = 0; j < ne->num_input; j++)
-      ne->output = config->cases_x[n][i][j];
-#endif
-    }
-    feedforward(nn);
-    // compute the mean error comparing with training output
-    double tmp = 0.;
-    for (j = 0; j < nn->layers[nn->num_of_layers-1].num_of_neurons; j++){
-     neuron *ne = &nn->layers[nn->num_of_layers-1].neurons[j];
-     y = ne->output;
-     tmp += fabs(y-config->cases_y[n][ne->global_id]);
-    }
-    err += tmp;
-   }
    return err;
-
    break;
-  // Mean Squared Error
-  case MSE:
-   for (n = 0; n < config->num_cases; n++){
-    int i, j;
-    // assign training input
-    for (i = 0; i < nn->layers[0].num_of_neurons; i++){
-     neuron *ne = &nn->layers[0].neurons[i];
-#if 1
-     ne->output = config->cases_x[n][ne->global_id][0];
-#else
-     for (j = 0; j < ne->num_input; j++)
-      ne->output = config->cases_x[n][i][j];
-#endif
-    }
-    feedforward(nn);
-    // compute the squared error comparing with the training output
-    double tmp = 0.;
-    for (j = 0; j < nn->layers[nn->num_of_layers-1].num_of_neurons; j++){
-     neuron *ne = &nn->layers[nn->num_of_layers-1].neurons[j];
-     y = ne->output;;
-     tmp += pow(y - config->cases_y[n][ne->global_id], 2);
-    }
-    err += tmp;
-   }
+ // Mean Squared Error
+ case MSE:
    return sqrt(err);
    break;
-  default:
+ default:
    return 0.;
    break;
  }
 }
+
+// error of the network with the weights w, evaluated in 'cache': the [neuron x case] matrices (see plan.h) of all the
+// blocks of PLAN_BLOCK_CASES training cases, one after the other. With steps NULL the cache is filled from scratch;
+// otherwise only the nsteps steps listed are evaluated again (see plan_forward_steps), which is all a change of the
+// weights of some steps needs if the steps that depend on them are listed too. The error is the one error() gives.
+// A recurrent plan carries state from one case to the next, which the cache does not: only use this on plans that
+// are not recurrent.
+double error_cached(const network_plan *plan, const double *w, double *cache, network_config *config,
+                    const uint32_t *steps, unsigned int nsteps){
+ const unsigned int block = PLAN_BLOCK_CASES;
+ unsigned int nb;
+ register int n;
+ double err, *act;
+
+ if (config->error_type != ME && config->error_type != MSE)
+  return 0.;
+
+ err = 0.;
+ for (n = 0; n < config->num_cases; n += nb) {
+  nb = MIN(block, config->num_cases - n);
+  act = &cache[(size_t)(n / block) * plan->num_of_neurons * block];
+  if (steps == NULL) {
+   load_cases(plan, config, act, block, n, nb);
+   plan_forward(plan, w, act, NULL, block, nb);
+  }
+  else
+   plan_forward_steps(plan, w, act, NULL, block, nb, steps, nsteps);
+  err = add_case_errors(plan, config, act, block, n, nb, err);
+ }
+
+ return (config->error_type == MSE) ? sqrt(err) : err;
+}
+
+// error of the network with its own weights, evaluated in the plan's buffers
+double error(network *nn, network_config *config){
+ network_plan *plan = nn->plan != NULL ? nn->plan : network_compile(nn);
+
+ return plan_error(plan, plan->weights, plan->act, plan->batch, config);
+}
+
+// error of the network with the weights w (the network's own if NULL), evaluated in the buffers of ctx. Neither the
+// network nor config is written, so threads with contexts of their own can call this at the same time.
+double error_context(network_context *ctx, const double *w, network_config *config){
+ return plan_error(ctx->plan, w != NULL ? w : ctx->plan->weights, ctx->act, ctx->batch, config);
+}
+
+// error of the network with the weights w (the network's own if NULL), like error_context, and its derivatives by every
+// weight in grad[] (laid out like plan->weights): one forward and one backward pass over the training cases. The
+// derivatives are exact for the network as it is evaluated; recurrent networks are not supported.
+double error_gradient(network_context *ctx, const double *w, network_config *config, double *grad){
+ const network_plan *plan = ctx->plan;
+ const unsigned int block = PLAN_BLOCK_CASES;
+ unsigned int nb, j, c, k;
+ register int n;
+ double err, e;
+
+ if (plan->recurrent) {
+  printf("The gradient of a recurrent network cannot be computed by backpropagation!\n");
+  exit(-1);
+ }
+ if (w == NULL)
+  w = plan->weights;
+
+ for (k = 0; k < plan->weight_count; k++)
+  grad[k] = 0.;
+
+ if (config->error_type != ME && config->error_type != MSE)
+  return 0.;
+
+ err = 0.;
+ for (n = 0; n < config->num_cases; n += nb) {
+  nb = MIN(block, config->num_cases - n);
+  load_cases(plan, config, ctx->batch, block, n, nb);
+  plan_forward(plan, w, ctx->batch, ctx->pre, block, nb);
+  err = add_case_errors(plan, config, ctx->batch, block, n, nb, err);
+
+  // derivative of the error by the outputs: sign(e) for ME. For MSE the 1 / sqrt(sum of e^2) factor of the derivative
+  // of the square root is only known at the end, so e is used here and the gradient is scaled below.
+  memset(ctx->delta, 0, (size_t)plan->num_of_neurons * block * sizeof(*ctx->delta));
+  for (j = 0; j < plan->num_of_outputs; j++) {
+   const uint32_t g = plan->output[j];
+   for (c = 0; c < nb; c++) {
+    e = ctx->batch[g * block + c] - config->cases_y[n + c][g];
+    ctx->delta[g * block + c] += (config->error_type == ME) ? (e > 0.) - (e < 0.) : e;
+   }
+  }
+  plan_backward(plan, w, ctx->batch, ctx->pre, ctx->delta, grad, block, nb);
+ }
+
+ if (config->error_type == ME)
+  return err;
+
+ err = sqrt(err);
+ for (k = 0; k < plan->weight_count; k++)
+  grad[k] = (err > 0.) ? grad[k] / err : 0.;
+ return err;
+}
+
+// one error of a numeric gradient, so that the differences only see the change of the weight
+static double numeric_error(network_context *ctx, const double *w, network_config *config){
+ network_context_reset(ctx);
+ return plan_error(ctx->plan, w, ctx->act, ctx->batch, config);
+}
+
+// error of the network with the weights w (the network's own if NULL), and its derivatives by every weight in grad[] by
+// central differences of step delta: two evaluations per weight, for any network. The evaluations are shared out among
+// up to 'threads' threads, thread t working in the context ctx[t] and on a copy of w of its own, so neither the
+// network nor w is written and every derivative is the same whatever the number of threads.
+double error_numeric_gradient(network_context **ctx, int threads, const double *w, network_config *config,
+                              double delta, double *grad){
+ const network_plan *plan = ctx[0]->plan;
+ const unsigned int n = plan->weight_count;
+ int failed = 0;
+
+ if (w == NULL)
+  w = plan->weights;
+ if (!PAR_WORTH((size_t)n * n * config->num_cases))
+  threads = 1;
+
+#pragma omp parallel num_threads(threads) reduction(+:failed)
+ {
+  network_context *my = ctx[omp_get_thread_num()];
+  double *wt = malloc(n * sizeof(*wt));
+  double err_minus, err_plus;
+  int k;
+
+  if (wt == NULL)
+   failed++;
+  else
+   memcpy(wt, w, n * sizeof(*wt));
+#pragma omp for schedule(static)
+  for (k = 0; k < (int)n; k++) {
+   if (wt == NULL)
+    continue;
+   wt[k] = w[k] - delta;
+   err_minus = numeric_error(my, wt, config);
+   wt[k] = w[k] + delta;
+   err_plus = numeric_error(my, wt, config);
+   wt[k] = w[k];
+   grad[k] = 0.5 * (err_plus - err_minus) / delta;
+  }
+  free(wt);
+ }
+ if (failed) {
+  printf("Not enough memory to allocate\ndouble *wt\n");
+  exit(-1);
+ }
+ return numeric_error(ctx[0], w, config);
+}
@@ -19,69 +19,130 @@
 #include "feedforward.h"
 #include "includes.h"
 #include "defines.h"
-#include "binom.h"
-#include "fact.h"
 #include "activation.h"
+#include "plan.h"
+#include "simd.h"
+#include "schedule.h"
 
 #define PI M_PI
 
-void feedforward(network *nn){
- register int i,j;
- register int l,n;
-
- /*
-  * scan all the layers (execpt the first)
-  */
- for (l = 1; l < nn->num_of_layers; l++){
-  /*
-   * scan all the neurons in layer 'l'
-   */
-  for (n = 0; n < nn->layers[l].num_of_neurons; n++) {
-
-   neuron *ne = &nn->layers[l].neurons[n];
-
-   double x = 0.;
-   double tmp;
-
-   /* fmv no more required */
-   //for (i=0;i<NEURON[id].nw;i++) NEURON[id].x[i]=NEURON[NEURON[id].connection[i]].output;
-   switch (ne->accumulator) {
-    case LINEAR:
-     for (i = 0; i < ne->num_input; i++)
-      x += ne->connection[i]->output * ne->w[i]; // linear product between w[] and x[]
-     break;
-    case LEGENDRE:
-     for (i = 0; i < ne->num_input; i++) {
-      for (tmp = 0., j = 0;j <= i; j++)
-        tmp += pow(ne->connection[i]->output,j)*binom(i,j)*binom((i+j-1)/2,j);
-      tmp *= pow(2, i) * ne->w[i];
-      x+=tmp;
-     }
-     break;
-    case LAGUERRE:
-     for (i = 0; i < ne->num_input; i++) {
-      for (tmp = 0., j = 0;j <= i;j++)
-	tmp += binom(i,j) * pow(ne->connection[i]->output, j)*pow(-1,j)/fact(j);
-      tmp *= ne->w[i];
-      x += tmp;
-     }
-     break;
-    case FOURIER:
-     for (i = 0; i < ne->num_input; i++) {
-      for(tmp = 0., j = 0;j <= i; j++)
-	tmp += sin(2. * j *PI *ne->connection[i]->output);
-      tmp *= ne->w[i];
-      x += tmp;
+// evaluate every step of a compiled network for ncases cases at once, with the weights in 'weights' (laid out like
+// plan->weights). act is a [neuron x case] matrix with a row stride of 'stride' cases (see plan.h): the inputs must
+// already be in it, every other row is overwritten. If pre is not NULL, the accumulated input of every step (the
+// argument of its activation function) is stored there, in the same layout, for the backward pass. A single case
+// with a stride of 1 sums its LINEAR steps with simd_dot_gather, a block adds one weight at a time to every case with
+// simd_axpy: the order of the sums differs, so the two agree only up to rounding, in the last bits. Nothing but act and
+// pre is written, so concurrent calls with different matrices are safe.
+void plan_forward(const network_plan *plan, const double *weights, double *act, double *pre, unsigned int stride,
+                  unsigned int ncases){
+ plan_forward_steps(plan, weights, act, pre, stride, ncases, NULL, plan->num_of_steps);
+}
+
+// the same for the nsteps steps listed in steps[] only (in evaluation order), or for steps 0 .. nsteps - 1 if steps is
+// NULL: every other row of act is left as it is. After a change of the weights of some steps, evaluating those steps
+// and the ones that depend on them gives the same act as a full evaluation.
+void plan_forward_steps(const network_plan *plan, const double *weights, double *act, double *pre, unsigned int stride,
+                        unsigned int ncases, const uint32_t *steps, unsigned int nsteps){
+ register unsigned int i,j;
+ unsigned int k, c;
+ double x[PLAN_BLOCK_CASES];
+ double tmp;
+
+ for (k = 0; k < nsteps; k++) {
+  const unsigned int s = steps != NULL ? steps[k] : k;
+  const double *w = &weights[plan->first[s]];
+  const uint32_t *src = &plan->source[plan->first[s]];
+  const unsigned int fanin = plan->fanin[s];
+  double *y = &act[plan->neuron[s] * stride];
+
+  for (c = 0; c < ncases; c++)
+   x[c] = 0.;
+
+  switch (plan->accumulator[s]) {
+   case LINEAR: // linear product between w[] and x[]
+    if (ncases == 1 && stride == 1)
+     x[0] = simd_dot_gather(fanin, w, act, src);
+    else
+     for (i = 0; i < fanin; i++)
+      simd_axpy(ncases, w[i], &act[src[i] * stride], x);
+    break;
+   case LEGENDRE:
+   case LAGUERRE: {
+    const double *table = (plan->accumulator[s] == LEGENDRE) ? plan->legendre : plan->laguerre;
+    for (i = 0; i < fanin; i++) {
+     const double *a = &act[src[i] * stride];
+     const double *coef = &table[i * (i + 1) / 2]; // degree i polynomial (see plan.h)
+     for (c = 0; c < ncases; c++) {
+      // Horner's scheme
+      for (tmp = coef[i], j = i; j > 0; j--)
+       tmp = tmp * a[c] + coef[j - 1];
+      x[c] += tmp * w[i];
      }
-     break;
-    default:
-     break;
+    }
    }
-   ne->output = activation(ne->activation, x);
+    break;
+   case FOURIER:
+    // sum of sin(2 j PI a) for j = 0 .. i. All the harmonics of an input come from one sin/cos pair by the angle
+    // addition formulas: sin((j+1)t) = sin(jt) cos(t) + cos(jt) sin(t), cos((j+1)t) = cos(jt) cos(t) - sin(jt) sin(t)
+    for (i = 0; i < fanin; i++) {
+     const double *a = &act[src[i] * stride];
+     double sin1[PLAN_BLOCK_CASES], cos1[PLAN_BLOCK_CASES];
+     double sinj[PLAN_BLOCK_CASES], cosj[PLAN_BLOCK_CASES], sum[PLAN_BLOCK_CASES];
+     if (i == 0)
+      continue; // sin(0) = 0
+     for (c = 0; c < ncases; c++) {
+      sinj[c] = sin1[c] = sin(2. * PI * a[c]);
+      cosj[c] = cos1[c] = cos(2. * PI * a[c]);
+      sum[c] = 0.;
+     }
+     for (j = 1; j <= i; j++)
+      for (c = 0; c < ncases; c++) {
+       sum[c] += sinj[c];
+       tmp = sinj[c] * cos1[c] + cosj[c] * sin1[c];
+       cosj[c] = cosj[c] * cos1[c] - sinj[c] * sin1[c];
+       sinj[c] = tmp;
+      }
+     for (c = 0; c < ncases; c++)
+      x[c] += sum[c] * w[i];
+    }
+    break;
+   default:
+    break;
   }
+
+  if (pre != NULL)
+   memcpy(&pre[plan->neuron[s] * stride], x, ncases * sizeof(*x));
+  activation_vector(plan->activation[s], plan->accuracy, x, y, ncases);
  }
 }
 
+// evaluate every step of a compiled network for a single case, reading and writing plan->act. Inputs must already be
+// in act[].
+void plan_feedforward(network_plan *plan){
+ plan_forward(plan, plan->weights, plan->act, NULL, 1, 1);
+}
+
+// the same for an evaluation context (see plan.h), with the weights w, or the network's own weights if w is NULL.
+// Inputs must already be in ctx->act[].
+void context_feedforward(network_context *ctx, const double *w){
+ plan_forward(ctx->plan, w != NULL ? w : ctx->plan->weights, ctx->act, NULL, 1, 1);
+}
+
+// feedforward propagation through the neuron structures: the outputs of the first layer are read from the neurons, and
+// the outputs of all the other neurons are written back to them. The network is compiled on first use.
+void feedforward(network *nn){
+ network_plan *plan = nn->plan != NULL ? nn->plan : network_compile(nn);
+ unsigned int i;
+
+ for (i = 0; i < plan->num_of_inputs; i++)
+  plan->act[plan->input[i]] = nn->neurons[plan->input[i]].output;
+
+ plan_feedforward(plan);
+
+ for (i = 0; i < plan->num_of_steps; i++)
+  nn->neurons[plan->neuron[i]].output = plan->act[plan->neuron[i]];
+}
+
 
 // input combining functions. Some widely used, some just plain strange.  Routine by Ray D. 6 September 2016
 flotype combine(const int combiner, const flotype currentval, const flotype ad){
@@ -100,133 +161,206 @@ flotype combine(const int combiner, const flotype currentval, const flotype ad){
 
 // return the identity element for the combiner - same numeric aliases for combiners as in the fn above. Routine by Ray
 // D. 6 September 2016
-inline flotype identity(const int combiner){ return (combiner == 1 ) ? ONE : ZERO; }
+inline flotype identity(const int combiner){ return (combiner == 2 ) ? ONE : ZERO; }
 
 // initialize an activation vector for use by a network. Routine by Ray D. 6 September 2016
 void init_activations(const struct nnet *const net, flotype *vec){
+    if (PAR_WORTH(net->nodecount)){
 #pragma omp parallel for
-    for (size_t pos = 0; pos < net->nodecount; pos++) vec[pos] = identity(net->transfer[pos]);
+	for (size_t pos = 0; pos < net->nodecount; pos++) vec[pos] = identity(net->accum[pos]);
+    }
+    else for (size_t pos = 0; pos < net->nodecount; pos++) vec[pos] = identity(net->accum[pos]);
+}
+
+// single-node transfer functions over a range of nodes, on the calling thread.  The sigmoids and softplus go through the
+// vectorized kernels of activation.c at the accuracy of the network.
+static void transfer_range(int fchoice, double *ins, double *outs, size_t width, enum activation_accuracy accuracy){
+    size_t count;
+    switch(fchoice){
+    case 0: // identity
+	for (count = 0; count < width; count++) outs[count] = ins[count];
+	break;
+    case 1: tanh_vector(ins, outs, width, accuracy); break;  // tanh sigmoid
+    case 2: arctan_vector(ins, outs, width, accuracy); break; // arctangent sigmoid
+    case 3: logistic_vector(ins, outs, width, accuracy); break; // unsigned logistic sigmoid
+    case 4: logistic_vector(ins, outs, width, accuracy); // signed logistic sigmoid
+	for (count = 0; count < width; count++) outs[count] = TWO * outs[count] - ONE;
+	break;
+    case 5: softsign_vector(ins, outs, width, accuracy); break; // softsign sigmoid
+    case 6: // mirrored logarithmic transfer
+	for (count = 0; count < width; count++)
+	    outs[count] = ins[count] > ZERO ? logarithm(absolute(ins[count]+ONE)) : -logarithm(absolute(-ins[count]-ONE));
+	break;
+    case 7: // signed step function
+	for (count = 0; count < width; count++) outs[count] = ins[count] > ZERO ? ONE : -ONE;
+	break;
+    case 8: // rectified linear unit
+	for (count = 0; count < width; count++) outs[count] = ins[count] > ZERO ? ins[count] : ZERO;
+	break;
+    case 9: softplus_vector(ins, outs, width, accuracy); break; // softplus rectifier
+    case 10: // logarithmic rectifier - mimics spike freq. in biological networks.
+	for (count = 0; count < width; count++) outs[count] = ins[count] >= ONE ? logarithm(ins[count]) : ZERO;
+	break;
+    case 11: // sinusoid Radial Bias Function
+	for (count = 0; count < width; count++) outs[count] = cosine(ins[count]);
+	break;
+    case 12: // gaussian Radial Bias Function
+	for (count = 0; count < width; count++) outs[count] = exponential(-ins[count] * ins[count]);
+	break;
+    case 13: // thin plate spline Radial Bias Function
+	for (count = 0; count < width; count++) outs[count] = (ins[count] * ins[count]) * logarithm(ins[count]);
+	break;
+    default: fprintf(stderr, "unknown transfer function\n"); exit(1);
+    }
 }
 
-// most of the popular transfer functions, and a few deliberate peculiarities, vectorized for OMP.
+// most of the popular transfer functions, and a few deliberate peculiarities.  A transfer wide enough to pay for a
+// parallel region (see PAR_WORTH) is split into one contiguous range per thread; anything narrower runs inline.
 // Routine by Ray D. 6 September 2016
-void transfer(int fchoice, double *ins, double *outs, size_t width){
+void transfer(int fchoice, double *ins, double *outs, size_t width, enum activation_accuracy accuracy){
     switch(fchoice){
-    case 0:
-#pragma omp parallel for
-	for (size_t count = 0; count < width; count++)
-	    outs[count] = ins[count]; break; // identity
-    case 1:
-#pragma omp parallel for
-	for (size_t count = 0; count < width; count++)
-	    outs[count] = hypertan(ins[count]); break;  // tanh sigmoid
-    case 2:
-#pragma omp parallel for
-	for (size_t count = 0; count < width; count++)
-	    outs[count] = arctan(ins[count]); break; // arctangent sigmoid
-    case 3:
-#pragma omp parallel for
-	for (size_t count = 0; count < width; count++)
-	    outs[count] = ONE / (ONE + exponential(-ins[count])); break; // unsigned logistic sigmoid
-    case 4:
-#pragma omp parallel for
-	for (size_t count = 0; count < width; count++)
-	    outs[count] = (TWO / (ONE + exp(-ins[count]))) - ONE; break; // signed logistic sigmoid
-    case 5:
-#pragma omp parallel for
-	for (size_t count = 0; count < width; count++)
-	    outs[count] = ins[count]/ (ONE + absolute(ins[count])); break; // softsign sigmoid
-    case 6:
-#pragma omp parallel for
-	for (size_t count = 0; count < width; count++) // mirrored logarithmic transfer
-	    outs[count] = ins[count] > ZERO ? logarithm(absolute(ins[count]+ONE)) : -logarithm(absolute(-ins[count]-ONE)); break;
-    case 7:
-#pragma omp parallel for
-	for (size_t count = 0; count < width; count++)
-	    outs[count] = ins[count] > ZERO ? ONE : -ONE; break; // signed step function
-    case 8:
-#pragma omp parallel for
-	for (size_t count = 0; count < width; count++)
-	    outs[count] = ins[count] > ZERO ? ins[count] : ZERO; break; // rectified linear unit
-    case 9:
-#pragma omp parallel for
-	for (size_t count = 0; count < width; count++)
-	    outs[count] = logarithm(ONE + exponential(ins[count])); break; // softplus rectifier
-    case 10:
-#pragma omp parallel for
-	for (size_t count = 0; count < width; count++)   // logarithmic rectifier - mimics spike freq. in biological networks.
-	    outs[count] = ins[count] >= ONE ? logarithm(ins[count]) : ZERO;
-    case 11:
-#pragma omp parallel for
-	for (size_t count = 0; count < width; count++) // sinusoid Radial Bias Function
-	    outs[count] = cosine(ins[count]); break;
-    case 12:
-#pragma omp parallel for
-	for (size_t count = 0; count < width; count++)   // gaussian Radial Bias Function
-	    outs[count] = exponential(-ins[count] * ins[count]); break;
-    case 13:
-#pragma omp parallel for
-	for (size_t count = 0; count < width; count++)   // thin plate spline Radial Bias Function
-	    outs[count] = (ins[count] * ins[count]) * logarithm(ins[count]); break;
 	// Note: Activation functions below this point operate on multiple nodes. This is an experimental capability.
     case 14:
-#pragma omp parallel for
 	for (size_t count = 1; count < width; count++) // multiplication by first input.
 	    outs[count] = ins[count] * ins[0];
 	outs[0] = 0; break;
     case 15:
-#pragma omp parallel for
-	for (size_t count = 0; count < (width-1); count+= 2){ // parallel pairwise addition & multiplication.
+	for (size_t count = 0; count + 1 < width; count+= 2){ // parallel pairwise addition & multiplication.
 	    outs[count] = ins[count] * ins[count + 1];
 	    outs[count + 1] = ins[count] + ins[count + 1];
 	} break;
-    default: fprintf(stderr, "unknown transfer function\n"); exit(1);
+    default:
+	if (PAR_WORTH(width)){
+#pragma omp parallel
+	    {
+		size_t threads = omp_get_num_threads(), me = omp_get_thread_num();
+		size_t lo = width * me / threads, hi = width * (me + 1) / threads;
+		transfer_range(fchoice, &(ins[lo]), &(outs[lo]), hi - lo, accuracy);
+	    }
+	}
+	else transfer_range(fchoice, ins, outs, width, accuracy);
     }
 }
 
+// reset nodes whose transfers have run so recurrent transfers start from the identity element for their accumulator.
+static void reset_nodes(const struct nnet *const net, flotype *const activations, size_t first, size_t width){
+    if (PAR_WORTH(width)){
+#pragma omp parallel for
+	for (size_t resetcount = first; resetcount < first + width; resetcount++)
+	    activations[resetcount] = identity(net->accum[resetcount]);
+    }
+    else for (size_t resetcount = first; resetcount < first + width; resetcount++)
+	activations[resetcount] = identity(net->accum[resetcount]);
+}
+
+
+// fire the transfer group starting at node: its accumulated inputs go through its transfer function into res, and are
+// recorded in pre if that is not NULL.
+static void fire(const struct nnet *const net, flotype *const activations, flotype *const res, flotype *const pre,
+		 size_t node){
+    const size_t width = net->transferwidths[node];
+    if (pre != NULL) memcpy(&(pre[node]), &(activations[node]), sizeof(flotype) * width);
+    transfer(net->transfer[node], &(activations[node]), &(res[node]), width, net->accuracy);
+    reset_nodes(net, activations, node, width);
+}
+
+// combine the incoming signals of a transfer group of a scheduled network, then fire it. Every source has already fired.
+// Each node pulls its inputs from its own contiguous run of the schedule and writes its activation once; additive nodes
+// take them as one dot product. pre and before are the history segments (see fwdprop), or NULL.
+static void fire_group(const struct nnet *const net, const struct nnet_schedule *const sched, size_t group,
+		       flotype *const activations, flotype *const res, flotype *const pre, flotype *const before){
+    const size_t width = net->transferwidths[group];
+    for (size_t node = group; node < group + width; node++){
+	const size_t first = sched->first[node], count = sched->first[node + 1] - first;
+	if (count == 0) continue;
+	if (net->accum[node] == 1)
+	    activations[node] += simd_dot_gather(count, &(sched->weights[first]), res, &(sched->sources[first]));
+	else {
+	    flotype value = activations[node];
+	    for (size_t pos = first; pos < first + count; pos++){
+		if (before != NULL) before[sched->synapses[pos]] = value;
+		value = combine(net->accum[node], value, res[sched->sources[pos]] * sched->weights[pos]);
+	    }
+	    activations[node] = value;
+	}
+    }
+    fire(net, activations, res, pre, group);
+}
+
+// evaluate a scheduled network one level at a time. When the widest level pays for it (see PAR_WORTH) a single
+// parallel region covers the whole pass: the groups of a level are shared among the threads, with the barrier at the
+// end of each level, and levels too small to share run on one thread while the others wait at that barrier.
+static void fwdprop_levels(const struct nnet *const net, const struct nnet_schedule *const sched,
+			   flotype *const activations, flotype *const res, flotype *const pre, flotype *const before){
+    if (PAR_WORTH(sched->widest)){
+#pragma omp parallel
+	for (size_t level = 0; level < sched->levelcount; level++){
+	    if (sched->work[level] >= PAR_GRAIN){
+#pragma omp for schedule(static)
+		for (size_t pos = sched->levels[level]; pos < sched->levels[level + 1]; pos++)
+		    fire_group(net, sched, sched->groups[pos], activations, res, pre, before);
+	    }
+	    else{
+#pragma omp single
+		for (size_t pos = sched->levels[level]; pos < sched->levels[level + 1]; pos++)
+		    fire_group(net, sched, sched->groups[pos], activations, res, pre, before);
+	    }
+	}
+    }
+    else for (size_t pos = 0; pos < sched->groupcount; pos++)
+	fire_group(net, sched, sched->groups[pos], activations, res, pre, before);
+}
 
 // fwdprop: The second argument is a pointer to a vector of inputs at least as long as the network's inputcount. The
 // third is a pointer to a vector of activation values at least as long as the network's nodecount. Reuse the activation
 // vector on subsequent calls for recurrent networks, otherwise be sure to initialize it to identity elements before the
-// call. The fourth argument is a pointer to a vector the same length as activation for recording the activation levels
-// at the time of firing. It's needed later for backprop, etc, but if you don't need it for training (ie, in production
-// or when training by other methods) you can leave it NULL. The last argument is a pointer to a vector of doubles at
-// least as long as net->outputcount, which will get filled with the network output.
+// call. The fourth argument is a pointer to a vector for recording what backprop() needs, at least HISTORYSIZE(net)
+// long: the output of every node, then the activation level of every node at the time of firing, then for every
+// synapse into a node that does not simply add its inputs, the value that node had accumulated just before the synapse
+// was combined into it. If you don't need it for training (ie, in production or when training by other methods) you
+// can leave it NULL. The last argument is a pointer to a vector of doubles at least as long as net->outputcount, which
+// will get filled with the network output.
 
 // Routine by Ray D, 31 Aug 2016.
 
 // Handles recurrent networks. Saves history if desired so we can later do backprop.  Handles combinators varying by
-// node.  Handles transfer functions varying by node.  Handles transfer functions of differing widths.
+// node.  Handles transfer functions varying by node.  Handles transfer functions of differing widths.  Feedforward
+// networks with a level schedule (see schedule.h) are evaluated level by level, in parallel when they are wide enough.
 
 void fwdprop(const struct nnet *const net, const flotype *const inputs, flotype *const activations,
 	     flotype *const history, flotype *const outputs){
     size_t wcount = 0;    size_t nodecount = 0;
     flotype *res = history != NULL ? history : alloca (sizeof(flotype) * net->nodecount);
+    flotype *pre = history != NULL ? &(history[net->nodecount]) : NULL;
+    flotype *before = history != NULL ? &(history[2 * net->nodecount]) : NULL;
     res[nodecount++] = ONE; // bias.
-#pragma omp parallel for
-    for (size_t incount = nodecount; incount <= net->inputcount; incount++)     // process inputs.
-	activations[incount] = combine(net->accum[incount],activations[incount], inputs[incount-1]);
-    for (wcount = 0; wcount < net->synapsecount; wcount++){     // process connections.
-	// perform transfer function for all nodes up to and including that required by current connection.
-	for (; nodecount <= net->sources[wcount]; nodecount+= net->transferwidths[nodecount]){
-	    transfer(net->transfer[nodecount], &(activations[nodecount]), &(res[nodecount]), net->transferwidths[nodecount]);
-	    // reset nodes whose transfers have run so recurrent transfers start from the identity element for their accumulator.
-#pragma omp parallel for
-	    for (size_t resetcount = nodecount; resetcount <= nodecount + net->transferwidths[nodecount]; resetcount++){
-		// capture activation history if history vector is provided. many training methods need it.
-		activations[resetcount] = identity(net->accum[resetcount]);
+    for (size_t incount = nodecount; incount <= net->inputcount; incount++)     // process inputs (added in, even past a Null combiner).
+	activations[incount] = net->accum[incount] == 0 ? activations[incount] + inputs[incount-1]
+	    : combine(net->accum[incount],activations[incount], inputs[incount-1]);
+    if (net->schedule != NULL) fwdprop_levels(net, net->schedule, activations, res, pre, before);
+    else {
+	for (wcount = 0; wcount < net->synapsecount; wcount++){     // process connections.
+	    // perform transfer function for all nodes up to and including that required by current connection.
+	    for (; nodecount <= net->sources[wcount]; nodecount+= net->transferwidths[nodecount])
+		fire(net, activations, res, pre, nodecount);
+	    // a run of additive synapses into the same node whose sources have all fired is a single dot product.
+	    size_t run = wcount + 1;
+	    if (net->accum[net->dests[wcount]] == 1)
+		while (run < net->synapsecount && net->dests[run] == net->dests[wcount] && net->sources[run] < nodecount) run++;
+	    if (run - wcount > 1){
+		activations[net->dests[wcount]] +=
+		    simd_dot_gather(run - wcount, &(net->weights[wcount]), res, &(net->sources[wcount]));
+		wcount = run - 1;
+	    }
+	    else {
+		if (before != NULL) before[wcount] = activations[net->dests[wcount]];
+		activations[net->dests[wcount]] =
+		    combine(net->accum[net->dests[wcount]],activations[net->dests[wcount]],res[net->sources[wcount]]*net->weights[wcount]);
 	    }
 	}
-	activations[net->dests[wcount]] =
-	    combine(net->accum[net->dests[wcount]],activations[net->dests[wcount]],res[net->sources[wcount]]*net->weights[wcount]);
+	// process transfer functions for any nodes following last weight source to be sure we get outputs for all output nodes.
+	for (; nodecount < net->nodecount; nodecount+= net->transferwidths[nodecount])
+	    fire(net, activations, res, pre, nodecount);
     }
-    // process transfer functions for any nodes following last weight source to be sure we get outputs for all output nodes.
-    for (; nodecount < net->nodecount; nodecount++){
-	transfer(net->nodecount, &(activations[nodecount]), &(res[nodecount]), net->transferwidths[nodecount]);
-#pragma omp parallel for
-	for (size_t resetcount = nodecount; resetcount <= nodecount + net->transferwidths[nodecount]; resetcount++)
-	    activations[resetcount] = identity(net->accum[resetcount]);
-    }
-    memcpy(&(res[0]), &(outputs[net->nodecount - net->outputcount-1]), sizeof(flotype) * net->outputcount); // send outputs to res
+    memcpy(outputs, &(res[net->nodecount - net->outputcount]), sizeof(flotype) * net->outputcount); // send outputs
 }
-
@@ -23,6 +23,7 @@
 #include "includes.h"
 #include "genetic_algorithm.h"
 #include "rnd.h"
+#include "plan.h"
 
 void memswap(void* a,void* b,size_t size){
  char t[size];
@@ -66,10 +67,15 @@ void par_qsort(void* data,size_t element_count,size_t element_size,__compar_fn_t
  }
 }
 
+/* the population is one [individual x weight] matrix, every row 'stride' doubles long (the weight count rounded up to
+   a cache line) and aligned on a cache line, and the ranking of its rows by error. Sorting, selection and the passage
+   to the next generation move ranking entries only, never rows. */
 typedef struct{
  double error;
- double* weights;
-} individual_t;
+ int row;
+} ranked_t;
+
+#define GA_ROW_ALIGN 64 /* bytes */
 
 int actual_weight_count(network *nn){
  int i, j, k;
@@ -80,56 +86,70 @@ int actual_weight_count(network *nn){
  return k;
 }
 
+/* the two children of the rows w1 and w2: their average, and the average moved by half the range of the weights
+   towards the middle of the range. An average right at the middle goes to either end, drawn from the random state
+   *seed of the pair of children. */
 static void crossover(network_config *config,
-    double w1,
-    double w2,
+    const double* w1,
+    const double* w2,
     double* n1,
-    double* n2){
- static int POSS = 1;
- double average = (w1 + w2) / 2;
- double delta = (config->wmax - config->wmin) / 2;
- double mid = (config->wmax + config->wmin) / 2;
-
- *n1 = average;
- if (average > mid)
-  *n2 = average - delta;
- else if (average < mid)
-  *n2 = average + delta;
- else { /* == mid*/
-  if (POSS) {
-   *n2 = config->wmax;
-   POSS = 0;
-  } else {
-   *n2 = config->wmin;
-   POSS = 1;
-  }
+    double* n2,
+    int count,
+    unsigned int *seed){
+ const double delta = (config->wmax - config->wmin) / 2;
+ const double mid = (config->wmax + config->wmin) / 2;
+ int k;
+
+ for (k = 0; k < count; ++k) {
+  double average = (w1[k] + w2[k]) / 2;
+  n1[k] = average;
+  n2[k] = (average > mid) ? average - delta : average + delta;
  }
+ for (k = 0; k < count; ++k)
+  if (n1[k] == mid)
+   n2[k] = (rnd_r(seed) < 0.5) ? config->wmax : config->wmin;
 }
 
+/* every weight of the row is changed with probability 'rate'. Rather than one draw per weight, the gaps between two
+   changed weights are drawn (geometric distribution), so a row costs a draw per change. */
 static void mutation(network_config *config,
-    double* weight,
-    double rate){
-
- double delta = config->wmax - config->wmin;
-
- if (rnd() > rate)
+    double* weights,
+    int count,
+    double rate,
+    unsigned int *seed){
+
+ const double delta = config->wmax - config->wmin;
+ const double scale = (rate < 1.) ? 1. / log(1. - rate) : 0.;
+ double* weight;
+ int k;
+
+ for (k = 0; ; ++k) {
+  if (rate < 1.) {
+   double gap = floor(log(1. - rnd_r(seed)) * scale);
+   if (gap >= count - k)
+    return;
+   k += (int)gap;
+  }
+  if (k >= count)
    return;
- if (rnd() > 0.5){
-  /* go plus */
-  *weight += (rnd() * delta / 2);
-  if (*weight > config->wmax)
-    *weight -= delta;
- } else {
-  /* go minus */
-  *weight -= (rnd() * delta / 2);
-  if (*weight < config->wmin)
-   *weight += delta;
+  weight = &weights[k];
+  if (rnd_r(seed) > 0.5){
+   /* go plus */
+   *weight += (rnd_r(seed) * delta / 2);
+   if (*weight > config->wmax)
+     *weight -= delta;
+  } else {
+   /* go minus */
+   *weight -= (rnd_r(seed) * delta / 2);
+   if (*weight < config->wmin)
+    *weight += delta;
+  }
  }
 }
 
-static int individual_compare(const void* a,const void* b){
- individual_t* ia = *(individual_t**)a;
- individual_t* ib = *(individual_t**)b;
+static int ranked_compare(const void* a,const void* b){
+ const ranked_t* ia = a;
+ const ranked_t* ib = b;
 
  if (ia->error > ib->error)
    return 1;
@@ -140,120 +160,163 @@ static int individual_compare(const void* a,const void* b){
  return 0;
 }
 
-static void init_individuals(unsigned long weight_cout,
-    individual_t** individuals, int size){
+static void init_individuals(double* weights, int stride, int weight_cout,
+    ranked_t* individuals, int size){
  int n, k;
- #pragma omp parallel for shared(weight_cout, individuals) private(n, k)
  for (n = 0; n < size; ++n)
   /* for each neuron in the network... */
   for (k = 0; k < weight_cout; k++)
-    individuals[n]->weights[k] = rnd();
+    weights[(size_t)individuals[n].row * stride + k] = rnd();
 }
 
+/* tournament selection: the best of 'tournament' individuals drawn at random from the population, which is ranked by
+   error, so the best is the one of the lowest rank */
+static const double* tournament_winner(const double* weights, int stride, const ranked_t* population, int size,
+    int tournament, unsigned int *seed){
+ int t, pick, best = size - 1;
+
+ for (t = 0; t < tournament; ++t) {
+  pick = MIN((int)(rnd_r(seed) * size), size - 1);
+  best = MIN(best, pick);
+ }
+ return &weights[(size_t)population[best].row * stride];
+}
+
+/* 'count' children of the (ranked) population, two per pair of parents won by tournament, crossed over and mutated.
+   Every pair of children draws from a random state of its own, so the children do not depend on the number of
+   threads. */
 static void reproduce_next_generation(
     network_config *config,
-    individual_t** individuals,
+    double* weights,
+    int stride,
+    const ranked_t* population,
     int size,
+    const ranked_t* children,
+    int count,
     int weight_cout,
-    double rate){
- int pos = size;
- int i, j, k;
- #pragma omp parallel for shared(config, pos,individuals,size,weight_cout,rate) private(i,j,k)
- for (i = 0; i < size; ++i) {
-  for (j = i + 1; j < size; ++j) {
-   for (k = 0; k < weight_cout; ++k) {
-    double w1 = individuals[i]->weights[k];
-    double w2 = individuals[j]->weights[k];
-    crossover(config, w1,w2,individuals[pos]->weights+k,individuals[pos+1]->weights+k);
-    mutation(config, individuals[pos]->weights+k,rate);
-    mutation(config, individuals[pos+1]->weights+k,rate);
-   }
-   #pragma omp atomic
-   pos+=2;
-  }
+    double rate,
+    double* spare,
+    int generation){
+ int pair;
+ #pragma omp parallel for schedule(static) if (PAR_WORTH((size_t)count * weight_cout))
+ for (pair = 0; pair < (count + 1) / 2; ++pair) {
+  unsigned int seed = rnd_seed(generation * count + pair);
+  const double* a = tournament_winner(weights, stride, population, size, config->tournament, &seed);
+  const double* b = tournament_winner(weights, stride, population, size, config->tournament, &seed);
+  double* n1 = &weights[(size_t)children[2 * pair].row * stride];
+  double* n2 = (2 * pair + 1 < count) ? &weights[(size_t)children[2 * pair + 1].row * stride] : spare;
+
+  crossover(config, a, b, n1, n2, weight_cout, &seed);
+  mutation(config, n1, weight_cout, rate, &seed);
+  mutation(config, n2, weight_cout, rate, &seed);
  }
 }
 
+/* the rows of the population are in the layout of the plan's weights (see plan.h): every thread evaluates them as
+   they are, in an evaluation context of its own, and the network is not touched. A recurrent network starts every
+   individual from its own state, whatever the thread and the order of the evaluations. */
 static void selection(
-    network *nn,
+    network_context **ctx,
+    int threads,
     network_config *config,
-    individual_t** individuals,int size){
- int pool_size=size*size;
- int n;
- #pragma omp parallel for shared(individuals,nn,config) private(n)
- for (n = 0; n < pool_size; ++n) {
-  #pragma omp critical
-  {
-   int i, j, k;
-   /* for each neuron */
-   for (k = 0, i = 0; i < nn->num_of_neurons; i++)
-    /* for each input...*/
-    for (j = 0; j < nn->neurons[i].num_input; j++, ++k)
-     nn->neurons[i].w[j] = individuals[n]->weights[k];
-
-   individuals[n]->error = error(nn, config);
+    const double* weights,
+    int stride,
+    ranked_t* individuals,int size){
+ const network_plan *plan = ctx[0]->plan;
+ #pragma omp parallel num_threads(threads) shared(individuals,ctx,config) \
+  if (PAR_WORTH((size_t)size * plan->weight_count * config->num_cases))
+ {
+  network_context *my = ctx[omp_get_thread_num()];
+  int n;
+  #pragma omp for schedule(dynamic, 8)
+  for (n = 0; n < size; ++n) {
+   network_context_reset(my);
+   individuals[n].error = error_context(my, &weights[(size_t)individuals[n].row * stride], config);
   }
  }
- par_qsort(individuals,pool_size,sizeof(individual_t*),individual_compare);
-// qsort(individuals, pool_size, sizeof(individual_t*), individual_compare);
+ par_qsort(individuals,size,sizeof(ranked_t),ranked_compare);
 }
 
+/* every generation breeds 'offspring' children from the npop individuals of the population, picked by tournament,
+   and evaluates them. The 'elite' best individuals stay on, with the errors they already have, and the best children
+   fill the rest of the population. The cost of a generation is one evaluation per child. */
 void genetic_algorithm(network *nn, network_config *config) {
  int output = config->verbosity;	/* screen output - on/off */
  int nmax =   config->nmax;		/* number of generations */
  int npop =   config->npop;		/* number of individuals per generation */
- int rate =   config->rate;		/* rate of change between one generation and the parent */
+ int offspring = config->offspring;	/* number of children per generation */
+ int elite =  config->elite;		/* number of best individuals carried over to the next generation */
+ double rate = config->rate;		/* rate of change between one generation and the parent */
  double eps  =   config->accuracy;      /* numerical accuracy */
 
  int i,j,k,n;
 
- int pool_size=npop*npop;
- individual_t** individuals=malloc(pool_size*sizeof(individual_t*));
+ int pool_size=npop+offspring;
+ int threads = MAX(1, MIN(offspring, omp_get_max_threads()));
+ int weight_cout = actual_weight_count(nn);
+ int stride = (weight_cout * sizeof(double) + GA_ROW_ALIGN - 1) / GA_ROW_ALIGN * GA_ROW_ALIGN / sizeof(double);
+ network_context **ctx;
+ double* weights = NULL;
+ ranked_t* individuals=malloc(pool_size*sizeof(ranked_t));
+ ranked_t* children;
  if(individuals==NULL){
   printf("GA: Not enough memory to allocate individual index table\n");
   exit(-1);
  }
+ children = individuals + npop;
 
+ /* one more row: the second child of an odd offspring count goes there */
+ if(posix_memalign((void**)&weights, GA_ROW_ALIGN, ((size_t)pool_size + 1) * MAX(stride, 1) * sizeof(double)) != 0){
+  printf("GA: Not enough memory to allocate weights\n");
+  exit(-1);
+ }
  for(i=0;i<pool_size;++i){
-  individuals[i]=malloc(sizeof(individual_t));
-  if(individuals[i]==NULL){
-   printf("GA: Not enough memory to allocate individuals\n");
-   exit(-1);
-  }
-  individuals[i]->weights=malloc(nn->num_of_neurons*MAX_IN*sizeof(double));
-  if(individuals[i]->weights==NULL){
-   printf("GA: Not enough memory to allocate weights\n");
-   exit(-1);
-  }
+  individuals[i].row=i;
+  individuals[i].error=0.;
  }
 
- int weight_cout = actual_weight_count(nn);
- init_individuals(weight_cout, individuals, npop);
+ ctx = malloc(threads * sizeof(network_context *));
+ if(ctx==NULL){
+  printf("GA: Not enough memory to allocate evaluation contexts\n");
+  exit(-1);
+ }
+ for (i = 0; i < threads; ++i)
+  ctx[i] = network_context_new(nn);
+
+ init_individuals(weights, stride, weight_cout, individuals, npop);
+ selection(ctx, threads, config, weights, stride, individuals, npop);
 
- for (n = 0; n < nmax; ++n) {
+ for (n = 0; n < nmax && individuals[0].error >= eps; ++n) {
 
-  reproduce_next_generation(config, individuals,npop,weight_cout,rate);
+  reproduce_next_generation(config, weights, stride, individuals, npop, children, offspring, weight_cout, rate,
+                            &weights[(size_t)pool_size * stride], n);
 
-  selection(nn, config, individuals,npop);
+  selection(ctx, threads, config, weights, stride, children, offspring);
+
+  /* the elite stays, the best children take the other places */
+  for (i = elite; i < npop; ++i) {
+   ranked_t tmp = individuals[i];
+   individuals[i] = children[i - elite];
+   children[i - elite] = tmp;
+  }
+  par_qsort(individuals,npop,sizeof(ranked_t),ranked_compare);
 
   if (output == ON)
-    printf("GA2: %d %.12g\n", n, individuals[0]->error);
-  if (individuals[0]->error<eps)
-    break;
+    printf("GA2: %d %.12g\n", n, individuals[0].error);
  }
 
- if (individuals[0]->error>eps && output == ON)
+ if (individuals[0].error>eps && output == ON)
     printf("GA2: after %d iterations error still greater than %g\n", nmax, eps);
 
  /* for each neuron */
  for (k = 0, i = 0; i < nn->num_of_neurons; i++)
   /* for each input ...*/
   for (j = 0; j < nn->neurons[i].num_input; j++, ++k)
-   nn->neurons[i].w[j] = individuals[0]->weights[k];
+   nn->neurons[i].w[j] = weights[(size_t)individuals[0].row * stride + k];
 
- for (i = 0; i < pool_size; ++i) {
-  free(individuals[i]->weights);
-  free(individuals[i]);
- }
+ free(weights);
  free(individuals);
+ for (i = 0; i < threads; ++i)
+  network_context_free(ctx[i]);
+ free(ctx);
 }
@@ -32,6 +32,7 @@
 #include "parser.h"
 #include "load.h"
 #include "save.h"
+#include "simd.h"
 
 static const struct option longopts[] =
 {
@@ -56,6 +57,7 @@ int main(int argc,char* argv[])
 	exit(-1);
  }
  progname=argv[0];
+ simd_init();
 
  while((optc=getopt_long(argc,argv,"hv",longopts,(int *) 0))!= EOF)
   switch (optc){
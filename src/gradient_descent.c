@@ -18,68 +18,69 @@
 
 #include "includes.h"
 #include "gradient_descent.h"
-
-
+#include "plan.h"
+#include "optimizer.h"
+
+// every iteration evaluates the gradient at the updated weights, and the error of the same pass is the error reported
+// for the iteration. For feedforward networks the gradient is exact and comes from one forward and one backward pass
+// over the training cases (see error_gradient). Recurrent networks, which backpropagation does not handle, and scripts
+// asking for GRADIENT NUMERIC get central differences with the step of the nxw grid instead, two error evaluations per
+// weight spread over the threads (see error_numeric_gradient). The step taken along the gradient is the one of the
+// configured optimizer (see optimizer.h); with PLAIN it is gamma times the gradient.
 void gradient_descent(network *nn, network_config *config) {
  int output = config->verbosity;	/* screen output - on/off */
  int nxw = config->nxw;			/* number of cells in one direction of the weight space */
  int maxiter = config->maxiter;		/* maximum number of iterations */
  double gamma = config->gamma;		/* step size */
  double eps = config->accuracy;		/* numerical accuracy */
- register int i,j,k;
- int n;
+ network_plan *plan = nn->plan != NULL ? nn->plan : network_compile(nn);
+ network_context *ctx = NULL;
+ network_context **ctxs = NULL;	/* one context per thread for the numeric gradient */
+ int threads = omp_get_max_threads();
+ optimizer *opt;
+ double *w = plan->weights;		/* all the weights of the network (see plan.h) */
+ int n, t;
  double delta;
  double err;
- double *wbackup;
  double *diff;
 
- wbackup = malloc((nn->num_of_neurons*MAX_IN+1)*sizeof(*wbackup));
- if (wbackup == NULL) {
-  printf("GD: Not enough memory to allocate\ndouble *wbackup\n");
-  exit(-1);
- }
-
- diff = malloc((nn->num_of_neurons*MAX_IN+1)*sizeof(*diff));
+ diff = malloc((plan->weight_count+1)*sizeof(*diff));
  if (diff == NULL) {
   printf("GD: Not enough memory to allocate\ndouble *diff\n");
   exit(-1);
  }
 
-
- err = 1.e8; // just a big number
  delta = (config->wmax - config->wmin) / nxw;
+ if (!plan->recurrent && config->gradient == ANALYTIC)
+  ctx = network_context_new(nn);
+ else {
+  ctxs = malloc(threads * sizeof(*ctxs));
+  if (ctxs == NULL) {
+   printf("GD: Not enough memory to allocate\nnetwork_context **ctxs\n");
+   exit(-1);
+  }
+  for (t = 0; t < threads; t++)
+   ctxs[t] = network_context_new(nn);
+ }
+ opt = optimizer_new(config->optimizer, plan->weight_count, gamma, config->momentum, config->decay);
 
+ err = ctx ? error_gradient(ctx, w, config, diff) : error_numeric_gradient(ctxs, threads, w, config, delta, diff);
  for (n = 0;(n < maxiter) && (err > eps); n++){
-  // backup the weights before anything else
-  for (k = 0, i = 0; i < nn->num_of_neurons; i++)
-   for (j = 0; j < nn->neurons[i].num_input; ++j, ++k)
-    wbackup[k] = nn->neurons[i].w[j];
-
-  // computes the derivatives in all directions (central difference - second order)
-  double err_minus;
-  double err_plus;
-  // computes the derivative for every single direction
-  for (k = 0, i = 0; i < nn->num_of_neurons; i++)
-   for (j = 0; j < nn->neurons[i].num_input; ++j, ++k) {
-    nn->neurons[i].w[j] = wbackup[k] - delta;
-    err_minus = error(nn, config);
-    nn->neurons[i].w[j] = wbackup[k] + delta;
-    err_plus = error(nn, config);
-    diff[k] = 0.5 * (err_plus - err_minus) / delta;
-   }
-
   // updates the weights according to the gradient
-  for (k = 0, i = 0; i < nn->num_of_neurons; i++)
-   for (j = 0; j < nn->neurons[i].num_input; ++j, ++k)
-    nn->neurons[i].w[j] = wbackup[k] - gamma * diff[k];
+  optimizer_step(opt, diff, 1., w);
 
-  // updates the error of the NN
-  err = error(nn, config);
+  // updates the error of the NN, and the gradient for the next iteration
+  err = ctx ? error_gradient(ctx, w, config, diff) : error_numeric_gradient(ctxs, threads, w, config, delta, diff);
   if (output == ON)
     printf("GD: %d %g\n", n, err);
  }
  if (output == ON)
    printf("\n");
- free(wbackup);
+ network_context_free(ctx);
+ if (ctxs != NULL)
+  for (t = 0; t < threads; t++)
+   network_context_free(ctxs[t]);
+ free(ctxs);
+ optimizer_free(opt);
  free(diff);
 }
@@ -0,0 +1,157 @@
+/* lbfgs.c -- This belongs to gneural_network
+
+   gneural_network is the GNU package which implements a programmable neural network.
+
+   Copyright (C) 2017 gneural_network developers
+
+   This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software
+   Foundation; either version 3, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// performs a limited memory BFGS (quasi-Newton) search of the best weights during the training process
+
+#include "includes.h"
+#include "lbfgs.h"
+#include "plan.h"
+#include "simd.h"
+
+#define LBFGS_ARMIJO 1e-4      /* sufficient decrease required of a step, as a fraction of the first order prediction */
+#define LBFGS_MAX_BACKTRACK 30 /* step halvings (at least) before the line search gives up */
+
+static double dot(unsigned int n, const double *x, const double *y) {
+ unsigned int i;
+ double sum = 0.;
+ for (i = 0; i < n; i++)
+  sum += x[i] * y[i];
+ return sum;
+}
+
+// the search direction d = -H g, where H is the inverse Hessian estimate built from the 'count' most recent pairs
+// s = change of the weights and y = change of the gradient, stored in a circular buffer of 'memory' rows ending at row
+// 'newest' (two loop recursion; the initial estimate is the identity times s.y / y.y of the newest pair).
+static void direction(unsigned int n, const double *g, const double *s, const double *y, const double *rho,
+                      double *alpha, int memory, int newest, int count, double *d) {
+ unsigned int i;
+ int j, row;
+
+ for (i = 0; i < n; i++)
+  d[i] = -g[i];
+ for (j = 0; j < count; j++) {
+  row = (newest - j + memory) % memory;
+  alpha[row] = rho[row] * dot(n, &s[row * n], d);
+  simd_axpy(n, -alpha[row], &y[row * n], d);
+ }
+ if (count > 0) {
+  double scale = 1. / (rho[newest] * dot(n, &y[newest * n], &y[newest * n]));
+  for (i = 0; i < n; i++)
+   d[i] *= scale;
+ }
+ for (j = count - 1; j >= 0; j--) {
+  row = (newest - j + memory) % memory;
+  simd_axpy(n, alpha[row] - rho[row] * dot(n, &y[row * n], d), &s[row * n], d);
+ }
+}
+
+// every iteration moves the weights along the quasi-Newton direction, by the first step of a backtracking line search
+// (starting from the full step) that lowers the error enough. The error and its gradient come from one forward and
+// one backward pass over the training cases (see error_gradient), so recurrent networks, which have no backward pass,
+// cannot be trained this way.
+void lbfgs(network *nn, network_config *config) {
+ int output = config->verbosity;	/* screen output - on/off */
+ int memory = config->memory;		/* number of (s, y) pairs kept */
+ int maxiter = config->maxiter;		/* maximum number of iterations */
+ double eps = config->accuracy;		/* numerical accuracy */
+ network_plan *plan = nn->plan != NULL ? nn->plan : network_compile(nn);
+ network_context *ctx;
+ unsigned int n = plan->weight_count;
+ double *w = plan->weights;		/* all the weights of the network (see plan.h) */
+ double *g, *d, *w0, *g0;		/* gradient, search direction, weights and gradient at the start of the line search */
+ double *s, *y, *rho, *alpha;		/* history of the weight and gradient changes, and the two loop coefficients */
+ double err, err0, dg, step, sy;
+ int newest = memory - 1, count = 0;
+ int iter, back;
+ unsigned int i;
+
+ if (plan->recurrent) {
+  printf("LBFGS: the network is recurrent, and its gradient can not be computed by backpropagation!\n");
+  exit(-1);
+ }
+ g = malloc(sizeof(double) * n);
+ d = malloc(sizeof(double) * n);
+ w0 = malloc(sizeof(double) * n);
+ g0 = malloc(sizeof(double) * n);
+ s = malloc(sizeof(double) * n * memory);
+ y = malloc(sizeof(double) * n * memory);
+ rho = malloc(sizeof(double) * memory);
+ alpha = malloc(sizeof(double) * memory);
+ if (g == NULL || d == NULL || w0 == NULL || g0 == NULL || s == NULL || y == NULL || rho == NULL || alpha == NULL) {
+  printf("LBFGS: Not enough memory to allocate\ndouble *g, *d, *w0, *g0, *s, *y, *rho, *alpha\n");
+  exit(-1);
+ }
+ ctx = network_context_new(nn);
+
+ err = error_gradient(ctx, w, config, g);
+ for (iter = 0; (iter < maxiter) && (err > eps); iter++) {
+  direction(n, g, s, y, rho, alpha, memory, newest, count, d);
+  dg = dot(n, d, g);
+  if (dg >= 0.) {
+   // not a descent direction (the history went stale): start over from steepest descent
+   count = 0;
+   direction(n, g, s, y, rho, alpha, memory, newest, count, d);
+   dg = dot(n, d, g);
+  }
+  if (dg == 0.)
+   break;		/* the gradient vanishes: nothing left to gain */
+
+  // without history the direction has no scale: make the first step no longer than one
+  step = count > 0 ? 1. : MIN(1., 1. / sqrt(-dg));
+  memcpy(w0, w, sizeof(double) * n);
+  memcpy(g0, g, sizeof(double) * n);
+  err0 = err;
+  for (back = 0; back < LBFGS_MAX_BACKTRACK; back++) {
+   for (i = 0; i < n; i++)
+    w[i] = w0[i] + step * d[i];
+   err = error_gradient(ctx, w, config, g);
+   if (err <= err0 + LBFGS_ARMIJO * step * dg)
+    break;
+   // minimum of the quadratic through err0, its slope dg and err, kept within a tenth and a half of the step
+   step = MAX(0.1 * step, MIN(0.5 * step, -0.5 * dg * step * step / (err - err0 - dg * step)));
+  }
+  if (back == LBFGS_MAX_BACKTRACK) {
+   memcpy(w, w0, sizeof(double) * n);
+   memcpy(g, g0, sizeof(double) * n);
+   err = err0;
+   if (count == 0)
+    break;		/* not even steepest descent lowers the error */
+   count = 0;
+   continue;
+  }
+
+  // remember the change of the weights and of the gradient, if the curvature along it is positive
+  newest = (newest + 1) % memory;
+  for (i = 0; i < n; i++) {
+   s[newest * n + i] = w[i] - w0[i];
+   y[newest * n + i] = g[i] - g0[i];
+  }
+  sy = dot(n, &s[newest * n], &y[newest * n]);
+  if (sy > 1e-12 * dot(n, &y[newest * n], &y[newest * n])) {
+   rho[newest] = 1. / sy;
+   count = MIN(count + 1, memory);
+  }
+  else
+   newest = (newest - 1 + memory) % memory;
+
+  if (output == ON)
+   printf("LBFGS: %d %g\n", iter, err);
+ }
+ if (output == ON)
+  printf("\n");
+ network_context_free(ctx);
+ free(g); free(d); free(w0); free(g0);
+ free(s); free(y); free(rho); free(alpha);
+}
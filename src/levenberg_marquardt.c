@@ -0,0 +1,191 @@
+/* levenberg_marquardt.c -- This belongs to gneural_network
+
+   gneural_network is the GNU package which implements a programmable neural network.
+
+   Copyright (C) 2017 gneural_network developers
+
+   This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software
+   Foundation; either version 3, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// performs a Levenberg-Marquardt search of the best weights during the training process
+
+#include "includes.h"
+#include "levenberg_marquardt.h"
+#include "plan.h"
+#include "feedforward.h"
+#include "backprop.h"
+#include "simd.h"
+
+#define LM_DAMPING_START 1e-1  /* damping of the first step: a cautious one, as the first Gauss-Newton step of a randomly
+                                  initialized network easily lands on a plateau of saturated neurons */
+#define LM_DAMPING_MIN   1e-12 /* the damping is not lowered below this */
+#define LM_DAMPING_MAX   1e12  /* the search ends when a step this short still raises the error */
+
+// the squared error of the training cases is the sum of the squares of the residuals r = (output - target), one per
+// case and output. Their derivatives by the weights are the rows of the Jacobian J; this adds up J^T J (lower triangle,
+// n x n, row major) and J^T r, and returns the sum of r^2. A Jacobian row is one backward pass of a single residual:
+// the forward pass is batched, and the backward passes walk the columns of the block (see plan_backward).
+static double normal_equations(network_context *ctx, const double *w, network_config *config, double *row,
+                               double *jtj, double *jtr){
+ const network_plan *plan = ctx->plan;
+ const unsigned int block = PLAN_BLOCK_CASES;
+ const unsigned int n = plan->weight_count;
+ unsigned int nb, j, c, k, g;
+ register int m;
+ double sse = 0., r;
+
+ memset(jtj, 0, sizeof(double) * n * n);
+ memset(jtr, 0, sizeof(double) * n);
+ for (m = 0; m < config->num_cases; m += nb) {
+  nb = MIN(block, config->num_cases - m);
+  for (k = 0; k < plan->num_of_inputs; k++) {
+   g = plan->input[k];
+   for (c = 0; c < nb; c++)
+    ctx->batch[g * block + c] = config->cases_x[m + c][g][0];
+  }
+  plan_forward(plan, w, ctx->batch, ctx->pre, block, nb);
+
+  for (c = 0; c < nb; c++)
+   for (j = 0; j < plan->num_of_outputs; j++) {
+    const uint32_t out = plan->output[j];
+    r = ctx->batch[out * block + c] - config->cases_y[m + c][out];
+    sse += r * r;
+
+    for (g = 0; g < plan->num_of_neurons; g++)
+     ctx->delta[g * block + c] = 0.;
+    ctx->delta[out * block + c] = 1.;
+    memset(row, 0, sizeof(double) * n);
+    plan_backward(plan, w, &ctx->batch[c], &ctx->pre[c], &ctx->delta[c], row, block, 1);
+
+    simd_axpy(n, r, row, jtr);
+    for (k = 0; k < n; k++)
+     if (row[k] != 0.)
+      simd_axpy(k + 1, row[k], row, &jtj[k * n]);
+   }
+ }
+ return sse;
+}
+
+// Cholesky factorization A = L L^T of the lower triangle of the n x n matrix a, in place. Returns 0 if a is not
+// (numerically) positive definite.
+static int cholesky(unsigned int n, double *a) {
+ unsigned int i, j, k;
+ double sum;
+
+ for (j = 0; j < n; j++) {
+  for (sum = a[j * n + j], k = 0; k < j; k++)
+   sum -= a[j * n + k] * a[j * n + k];
+  if (!(sum > 0.))
+   return 0;
+  a[j * n + j] = sqrt(sum);
+  for (i = j + 1; i < n; i++) {
+   for (sum = a[i * n + j], k = 0; k < j; k++)
+    sum -= a[i * n + k] * a[j * n + k];
+   a[i * n + j] = sum / a[j * n + j];
+  }
+ }
+ return 1;
+}
+
+// solve L L^T x = b, with L from cholesky(); x overwrites b
+static void cholesky_solve(unsigned int n, const double *l, double *b) {
+ unsigned int i, k;
+
+ for (i = 0; i < n; i++) {
+  for (k = 0; k < i; k++)
+   b[i] -= l[i * n + k] * b[k];
+  b[i] /= l[i * n + i];
+ }
+ for (i = n; i-- > 0;) {
+  for (k = i + 1; k < n; k++)
+   b[i] -= l[k * n + i] * b[k];
+  b[i] /= l[i * n + i];
+ }
+}
+
+// every iteration solves the damped normal equations (J^T J + lambda D) dw = -J^T r, D being the diagonal of J^T J,
+// and tries the step dw. If the error drops the step is taken and lambda lowered, towards Gauss-Newton; otherwise lambda
+// is raised, towards a short gradient step, and the step tried again. Only the squared error (MSE) is a sum of squares
+// of residuals, and recurrent networks have no backward pass: either is rejected.
+void levenberg_marquardt(network *nn, network_config *config) {
+ int output = config->verbosity;	/* screen output - on/off */
+ int maxiter = config->maxiter;		/* maximum number of iterations */
+ double eps = config->accuracy;		/* numerical accuracy */
+ network_plan *plan = nn->plan != NULL ? nn->plan : network_compile(nn);
+ network_context *ctx;
+ unsigned int n = plan->weight_count;
+ double *w = plan->weights;		/* all the weights of the network (see plan.h) */
+ double *jtj, *a, *jtr, *dw, *wt;	/* normal equations, their damped copy, right hand side, step and trial weights */
+ double lambda = LM_DAMPING_START;
+ double err, errt, floor;
+ int iter;
+ unsigned int i, k;
+
+ if (config->error_type != MSE) {
+  printf("LM: Levenberg-Marquardt only minimizes the squared error (ERROR_TYPE MSE)!\n");
+  exit(-1);
+ }
+ if (plan->recurrent) {
+  printf("LM: the network is recurrent, and its Jacobian can not be computed by backpropagation!\n");
+  exit(-1);
+ }
+ jtj = malloc(sizeof(double) * n * n);
+ a = malloc(sizeof(double) * n * n);
+ jtr = malloc(sizeof(double) * n);
+ dw = malloc(sizeof(double) * n);
+ wt = malloc(sizeof(double) * n);
+ if (jtj == NULL || a == NULL || jtr == NULL || dw == NULL || wt == NULL) {
+  printf("LM: Not enough memory to allocate\ndouble *jtj, *a, *jtr, *dw, *wt\n");
+  exit(-1);
+ }
+ ctx = network_context_new(nn);
+
+ // wt doubles as the scratch Jacobian row
+ err = sqrt(normal_equations(ctx, w, config, wt, jtj, jtr));
+ for (iter = 0; (iter < maxiter) && (err > eps); iter++) {
+  // a weight no residual depends on has a zero diagonal: keep its pivot away from zero
+  for (floor = 0., i = 0; i < n; i++)
+   floor = MAX(floor, jtj[i * n + i]);
+  floor = MAX(floor * 1e-12, 1e-300);
+
+  memcpy(a, jtj, sizeof(double) * n * n);
+  for (i = 0; i < n; i++)
+   a[i * n + i] += lambda * MAX(jtj[i * n + i], floor);
+  if (!cholesky(n, a)) {
+   lambda *= 10.;
+   if (lambda > LM_DAMPING_MAX)
+    break;
+   continue;
+  }
+  for (k = 0; k < n; k++)
+   dw[k] = -jtr[k];
+  cholesky_solve(n, a, dw);
+
+  for (k = 0; k < n; k++)
+   wt[k] = w[k] + dw[k];
+  errt = error_context(ctx, wt, config);
+  if (errt < err) {
+   memcpy(w, wt, sizeof(double) * n);
+   lambda = MAX(lambda / 10., LM_DAMPING_MIN);
+   err = sqrt(normal_equations(ctx, w, config, wt, jtj, jtr));
+  }
+  else {
+   lambda *= 10.;
+   if (lambda > LM_DAMPING_MAX)
+    break;		/* not even a vanishing step lowers the error */
+  }
+
+  if (output == ON)
+   printf("LM: %d %g %g\n", iter, err, lambda);
+ }
+ if (output == ON)
+  printf("\n");
+ network_context_free(ctx);
+ free(jtj); free(a); free(jtr); free(dw); free(wt);
+}
@@ -19,60 +19,104 @@
 #include "includes.h"
 #include "msmco.h"
 #include "rnd.h"
+#include "plan.h"
 
+// the samples one thread draws in a stage: its evaluation context, the weights of the sample being tried, and the
+// best sample it drew so far in the stage
+typedef struct {
+ network_context *ctx;
+ double *w, *wbest;
+ double e_best;
+} sampler;
+
+// every stage draws nmax samples around the best weights found so far, in a box that shrinks by gamma from one
+// stage to the next, so the stages follow each other. The samples of a stage are shared out among the threads when
+// the stage is worth it (see PAR_WORTH), each drawing into weights and activations of its own; at the end of the
+// stage the best sample of every thread is compared with the best so far. Every sample draws its numbers from a random state of its own, and ties go to the
+// first sample, so the result does not depend on the number of threads.
 void msmco(network *nn, network_config *config) {
  int output = config->verbosity;/* screen output - on/off */
  int mmax =config->mmax;        /* number of MC outer iterations */
  int nmax = config->nmax;    /* number of MC inner iterations */
  double gamma = config->gamma;/* rate to reduce the space of search at every iteration */
- register int i, j, k;
- int m, n;
- double e0, err;
+ network_plan *plan = nn->plan != NULL ? nn->plan : network_compile(nn);
+ unsigned int nw = plan->weight_count;
+ int threads = MAX(1, MIN(nmax, omp_get_max_threads()));
+ register int t;
+ int m;
+ double e0;
+ double *w_total;
  double *wbest;
  double delta = config->wmax - config->wmin;
+ sampler *s;
 
  e0=1.e8; // just a big number
 
- wbest = malloc((nn->num_of_neurons*MAX_IN+1)*sizeof(*wbest));
- if(wbest==NULL){
-  printf("MSMCO: Not enough memory to allocate\ndouble *wbest]\n");
+ w_total = malloc(((size_t)2 * threads + 1) * nw * sizeof(*w_total) + 1);
+ s = malloc(threads * sizeof(*s));
+ if(w_total==NULL || s==NULL){
+  printf("MSMCO: Not enough memory to allocate\ndouble *w_total, sampler *s\n");
   exit(0);
  }
+ wbest = w_total;
+ memcpy(wbest, plan->weights, nw * sizeof(*wbest));
+ for (t = 0; t < threads; t++) {
+  s[t].ctx = network_context_new(nn);
+  s[t].w = w_total + (size_t)(2 * t + 1) * nw;
+  s[t].wbest = s[t].w + nw;
+ }
 
- #pragma omp parallel for private(n,i,j,err)
  for (m = 0; m < mmax; m++) {
-  for (n = 0; n < nmax; n++) {
-   // random weights
-   if (m == 0) {
-    for (i = 0; i < nn->num_of_neurons; i++){
-     for (j = 0; j < nn->neurons[i].num_input; ++j) {
-      nn->neurons[i].w[j] = 0.5 * delta +
-		(0.5 - rnd()) * 0.5 * delta ;
-     }
+  double scale = 0.5 * delta * pow(gamma,m);
+
+  for (t = 0; t < threads; t++)
+   s[t].e_best = 1.e8;
+#pragma omp parallel num_threads(threads) if (PAR_WORTH((size_t)nmax * nw * config->num_cases))
+  {
+   sampler *my = &s[omp_get_thread_num()];
+   unsigned int k, seed;
+   int n;
+   double err;
+
+#pragma omp for schedule(static)
+   for (n = 0; n < nmax; n++) {
+    // random weights
+    seed = rnd_seed(m * nmax + n);
+    if (m == 0) {
+     for (k = 0; k < nw; k++)
+      my->w[k] = 0.5 * delta + (0.5 - rnd_r(&seed)) * 0.5 * delta;
+    } else {
+     for (k = 0; k < nw; k++)
+      my->w[k] = wbest[k] + (0.5 - rnd_r(&seed)) * scale;
     }
-   } else {
-    for (k = 0, i = 0; i < nn->num_of_neurons; i++)
-     for (j = 0; j < nn->neurons[i].num_input; ++j, ++k)
-      nn->neurons[i].w[j] = wbest[k] + (0.5 - rnd()) * 0.5 * delta * pow(gamma,m);
-   }
-   // update error
-   err = error(nn, config);
-   if (err < e0) {
+    network_context_reset(my->ctx);
+    // update error
+    err = error_context(my->ctx, my->w, config);
+    if (err < my->e_best) {
+     double *tmp = my->wbest;
+     my->wbest = my->w;
+     my->w = tmp;
+     my->e_best = err;
+    }
+   } // end of n-loop
+  }
+
+  // the threads drew consecutive samples in order: the first of equal errors is the one of the lowest thread
+  for (t = 0; t < threads; t++)
+   if (s[t].e_best < e0) {
     // update/store the new best weights
-    e0 = err;
-    for (k = 0, i = 0; i < nn->num_of_neurons; i++)
-     for (j = 0; j < nn->neurons[i].num_input; ++j, ++k)
-      wbest[k] = nn->neurons[i].w[j];
+    e0 = s[t].e_best;
+    memcpy(wbest, s[t].wbest, nw * sizeof(*wbest));
    }
-  } // end of n-loop
   if (output==ON)
     printf("MSMCO: %d %g\n",m,e0);
  } // end of m-loop
 
  // update the weights of the network with the best found solution
- for (k = 0, i = 0; i < nn->num_of_neurons; i++)
-  for (j = 0; j < nn->neurons[i].num_input; ++j, ++k)
-   nn->neurons[i].w[j] = wbest[k];
+ memcpy(plan->weights, wbest, nw * sizeof(*wbest));
 
- free(wbest);
+ for (t = 0; t < threads; t++)
+  network_context_free(s[t].ctx);
+ free(s);
+ free(w_total);
 }
@@ -39,7 +39,10 @@
 #include "random_search.h"
 #include "simulated_annealing.h"
 #include "gradient_descent.h"
+#include "lbfgs.h"
+#include "levenberg_marquardt.h"
 #include "genetic_algorithm.h"
+#include "plan.h"
 
 /*
  * network* API
@@ -72,8 +75,12 @@ void network_free(network *nn)
  if (nn->neurons) {
 	int i;
 
-	for (i = 0; i < nn->num_of_neurons; ++i)
+	for (i = 0; i < nn->num_of_neurons; ++i) {
+		/* once compiled, the weights belong to the plan */
+		if (nn->plan)
+			nn->neurons[i].w = NULL;
 		_free_neuron_data(&nn->neurons[i]);
+	}
 
 	free(nn->neurons);
 	}
@@ -81,6 +88,7 @@ void network_free(network *nn)
  if (nn->layers)
 	free(nn->layers);
 
+ network_plan_free(nn->plan);
  free(nn);
 }
 
@@ -292,6 +300,11 @@ void network_run_algorithm(network *nn, network_config *config)
 	[GRADIENT_DESCENT]	= gradient_descent,
 	[GENETIC_ALGORITHM]	= genetic_algorithm,
 	[MSMCO]			= msmco,
+	[LBFGS]			= lbfgs,
+	[LEVENBERG_MARQUARDT]	= levenberg_marquardt,
+	[PARALLEL_TEMPERING]	= parallel_tempering,
+	[INCREMENTAL_ANNEALING]	= incremental_annealing,
+	[GENETIC_TOURNAMENT]	= genetic_algorithm,
   };
 
   /*
@@ -305,6 +318,10 @@ void network_run_algorithm(network *nn, network_config *config)
 
   /* network_print(nn); */
 
+  /* the topology is final: compile it once, every method runs off the plan */
+  network_compile(nn);
+  nn->plan->accuracy = config->activation_accuracy;
+
   supported_optimization_methods[config->optimization_type](nn, config);
 }
 
@@ -341,6 +358,9 @@ void network_config_set_default(network_config *config)
   config->save_neural_network = OFF;
   config->initial_weights_randomization = ON;
   config->error_type = MSE;
+  config->activation_accuracy = EXACT;
+  config->optimizer = PLAIN;
+  config->gradient = ANALYTIC;
 }
 
 network_config *network_config_alloc_default()
@@ -387,7 +407,7 @@ void SwapRange(struct nnet *net, int start, int star2, int len){
 // output ranges accidentally breaking input/output to connectivity mappings even though it preserves connectivity.
 int InsertNodes(struct nnet *net, int startloc, int newcount, int transferfn, int accumfn, unsigned int xfersize){
     if (net == NULL || newcount < 0) {fprintf(stderr, "Program Error: improper call to InsertNodes.\n");exit(1);}
-    if (net->nodecount == 0) {net->nodecount++; net->inputcount++; startloc++;}
+    if (net->nodecount == 0) {net->nodecount++; startloc = MAX(startloc, 1);}
     int *newtrans = (int *)malloc((net->nodecount + newcount)*sizeof(int));
     int *newacc = (int *)malloc((net->nodecount + newcount)*sizeof(int));
     unsigned int *xwidth = (unsigned int *)malloc((net->nodecount + newcount)*sizeof(int));
@@ -420,7 +440,7 @@ int AddHiddenNodes(struct nnet *net, int newnodes, int transferfn, int accumfn,
 // inserts input nodes to existing network.  New nodes will be at end of current input (but you can SwapRange them within input if you want).
 int AddInputNodes(struct nnet *net, int newnodes, int transferfn, int accumfn, unsigned int xfersize){
     net->inputcount += newnodes;
-    return (InsertNodes(net, net->inputcount-newnodes, newnodes, transferfn, accumfn, xfersize));
+    return (InsertNodes(net, 1+net->inputcount-newnodes, newnodes, transferfn, accumfn, xfersize));
 }
 
 
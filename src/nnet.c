@@ -21,6 +21,9 @@
 #include "defines.h"
 #include "parser.h"
 #include "save.h"
+#include "simd.h"
+#include "schedule.h"
+#include "train.h"
 
 #define HELPSTRING  "usage: nnet <filename> | nnet -v | nnet -h | nnet -H | nnet -l \nOptions:\n\
   -h, -?, --help:  print this help and exit.\n\
@@ -68,7 +71,7 @@ void GetFileNames(char* readname, struct conf *config, const char* arg){
         for (index = 1; serialend+index < len; index++) config->savename[serialend+index] = readname[index];
         config->savename[serialend+index+1] = 0;
     }
-    else {strcpy(config->savename, readname); config->savename[len]= 0;}
+    else {strcpy(config->savename, readname); config->savename[len+1]= 0;}
     strcat(config->savename,"out");
 }
 
@@ -96,29 +99,36 @@ int main(int argc, char** argv){
     struct nnet newt;       struct conf netconf;            struct slidingbuffer bf;
     char fname[256];  fname[0] = 0;  char* filename = &(fname[0]);
     if (!HandleOptions(argc, argv)) exit(0);
+    simd_init();
     if (argc > 2) fprintf(stderr, "%s does not process more than one nnet script in a single invocation.\n", argv[0]);
     if (argc != 2) {fprintf(stderr, "Usage:  %s [filename] where 'filename.nnet' is the name of a nnet script.\n", argv[0]); exit(1);}
     bzero(&newt, sizeof(struct nnet));  bzero(&bf, sizeof(struct slidingbuffer)); bzero(&netconf, sizeof(struct conf));
     GetFileNames(filename, &netconf, argv[1]);
     if (NULL == (bf.input = fopen(filename, "r"))) {fprintf(stderr, "unable to open %s\n", filename); exit(1);}
     nnetparser( &newt, &netconf, &bf);
+    newt.schedule = nnet_schedule(&newt);
     fflush(stdout);
     PrintWarnings(&bf);
     if ((netconf.flags & SILENCE_DEBUG) != 0){
 	printf("\n\nParse successful.");
 	printf("\n%d nodes created. Node 0 is a bias node.  ", newt.nodecount);
-	if (newt.inputcount > 0) printf("Nodes {1 %d} are input nodes.  ", newt.inputcount-1);
-	if (newt.nodecount - newt.inputcount - newt.outputcount > 0)
-	    printf(" Nodes {%d %d} are hidden nodes.", newt.inputcount, (newt.nodecount-1) - newt.outputcount);
+	if (newt.inputcount > 0) printf("Nodes {1 %d} are input nodes.  ", newt.inputcount);
+	if (newt.nodecount - 1 - newt.inputcount - newt.outputcount > 0)
+	    printf(" Nodes {%d %d} are hidden nodes.", newt.inputcount+1, (newt.nodecount-1) - newt.outputcount);
 	if (newt.outputcount > 0) printf(" Nodes {%d %d} are output nodes. ", newt.nodecount - newt.outputcount, (newt.nodecount-1));
 	printf("\n%d Connections created. ", newt.synapsecount);
 	for (int syn = 0; syn < newt.synapsecount; syn++) printf("%d=%d->%d,",syn,newt.sources[syn],newt.dests[syn]); printf("\b \n");
+	if (newt.schedule != NULL) printf("Feedforward network: %d levels, the widest holding %d nodes and connections.\n",
+					  newt.schedule->levelcount, newt.schedule->widest);
+	else printf("Recurrent network: nodes are activated in connection order.\n");
     }
     fclose(bf.input); bf.input = NULL;
+    runplans(&newt);
     NameOutputFile(filename, &netconf);
     FILE *outf = fopen(filename, "w");
     if (outf == NULL) {fprintf(stderr, "unable to open %s", filename);exit(1);}
     if ((netconf.flags & SILENCE_DEBUG) != 0)debugnnet(&newt);
     nnetwriter( &newt, &netconf, outf);
     fclose(outf);
+    nnet_schedule_free(newt.schedule);
 }
@@ -0,0 +1,111 @@
+/* optimizer.c -- This belongs to gneural_network
+
+   gneural_network is the GNU package which implements a programmable neural network.
+
+   Copyright (C) 2017 gneural_network developers
+
+   This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software
+   Foundation; either version 3, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// weight updates of the gradient methods: plain steps, momentum, Nesterov, RMSProp and Adam
+
+#include "includes.h"
+#include "optimizer.h"
+#include "simd.h"
+
+optimizer *optimizer_new(enum gradient_optimizer method, unsigned int count, double rate, double momentum, double decay){
+ optimizer *opt = calloc(1, sizeof(*opt));
+ if (opt == NULL) {
+  printf("optimizer: Not enough memory to allocate\noptimizer *opt\n");
+  exit(-1);
+ }
+ opt->method = method;
+ opt->count = count;
+ opt->rate = rate;
+ opt->momentum = momentum;
+ opt->decay = decay;
+ // RMSProp has no velocity of its own, but the adaptive sweep keeps one: with a decay of zero it is the last gradient
+ if (method != PLAIN)
+  opt->m = calloc(count ? count : 1, sizeof(double));
+ if (method == RMSPROP || method == ADAM)
+  opt->v = calloc(count ? count : 1, sizeof(double));
+ if ((method != PLAIN && opt->m == NULL) || ((method == RMSPROP || method == ADAM) && opt->v == NULL)) {
+  printf("optimizer: Not enough memory to allocate\ndouble *m, *v\n");
+  exit(-1);
+ }
+ return opt;
+}
+
+void optimizer_free(optimizer *opt){
+ if (opt == NULL)
+  return;
+ free(opt->m);
+ free(opt->v);
+ free(opt);
+}
+
+// update weights first .. first + n - 1. beta1, a, b and eps are the coefficients of the sweep (see simd.h).
+static void optimizer_range(optimizer *opt, unsigned int first, unsigned int n, const double *g, double scale, double *w,
+                            double beta1, double a, double b, double eps){
+ switch (opt->method) {
+  case PLAIN:
+   simd_axpy(n, -a * scale, &g[first], &w[first]);
+   break;
+  case MOMENTUM:
+  case NESTEROV:
+   simd_momentum_step(n, &g[first], scale, beta1, a, b, &opt->m[first], &w[first]);
+   break;
+  case RMSPROP:
+  case ADAM:
+   simd_adaptive_step(n, &g[first], scale, beta1, opt->decay, a, b, eps, &opt->m[first], &opt->v[first], &w[first]);
+   break;
+ }
+}
+
+void optimizer_step(optimizer *opt, const double *g, double scale, double *w){
+ double beta1 = 0., a = opt->rate, b = 0., eps = OPTIMIZER_EPSILON;
+
+ opt->steps++;
+ switch (opt->method) {
+  case PLAIN:
+   break;
+  case MOMENTUM:
+   beta1 = opt->momentum;
+   a = 0.;
+   b = opt->rate;
+   break;
+  case NESTEROV:
+   beta1 = opt->momentum;
+   b = opt->rate * opt->momentum;
+   break;
+  case RMSPROP:
+   break;
+  case ADAM: {
+   // the bias corrections m / (1 - momentum^t) and v / (1 - decay^t) folded into the step and into eps
+   double c1 = 1. - pow(opt->momentum, (double)opt->steps);
+   double c2 = sqrt(1. - pow(opt->decay, (double)opt->steps));
+   beta1 = opt->momentum;
+   a = 0.;
+   b = opt->rate * c2 / c1;
+   eps *= c2;
+  }
+   break;
+ }
+
+ if (PAR_WORTH(opt->count)) {
+#pragma omp parallel
+  {
+   unsigned int threads = omp_get_num_threads(), me = omp_get_thread_num();
+   unsigned int lo = (unsigned long)opt->count * me / threads, hi = (unsigned long)opt->count * (me + 1) / threads;
+   optimizer_range(opt, lo, hi - lo, g, scale, w, beta1, a, b, eps);
+  }
+ }
+ else
+  optimizer_range(opt, 0, opt->count, g, scale, w, beta1, a, b, eps);
+}
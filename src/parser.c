@@ -34,6 +34,9 @@ enum main_token_id {
   _SAVE_NEURAL_NETWORK,
 
   _ERROR_TYPE,
+  _ACTIVATION_ACCURACY,
+  _GRADIENT_OPTIMIZER,
+  _GRADIENT,
   _INITIAL_WEIGHTS_RANDOMIZATION,
 
   _NUMBER_OF_TRAINING_CASES,
@@ -58,6 +61,9 @@ static const char *main_token_n[] = {
   [_LOAD_NEURAL_NETWORK]		= "LOAD_NEURAL_NETWORK",
   [_SAVE_NEURAL_NETWORK]		= "SAVE_NEURAL_NETWORK",
   [_ERROR_TYPE]				= "ERROR_TYPE",
+  [_ACTIVATION_ACCURACY]		= "ACTIVATION_ACCURACY",
+  [_GRADIENT_OPTIMIZER]			= "GRADIENT_OPTIMIZER",
+  [_GRADIENT]				= "GRADIENT",
   [_INITIAL_WEIGHTS_RANDOMIZATION]	= "INITIAL_WEIGHTS_RANDOMIZATION",
   [_NUMBER_OF_TRAINING_CASES]		= "NUMBER_OF_TRAINING_CASES",
   [_TRAINING_CASE]			= "TRAINING_CASE",
@@ -69,7 +75,7 @@ static const char *main_token_n[] = {
 };
 
 
-const int main_token_count = 17;
+const int main_token_count = 20;
 
 enum direction_enum {
   _IN,
@@ -88,6 +94,28 @@ static const char *error_names[] = {
 };
 const int error_name_count = 2;
 
+static const char *accuracy_names[] = {
+    [EXACT] = "EXACT",
+    [FAST] = "FAST",
+    [FASTEST] = "FASTEST",
+};
+const int accuracy_name_count = 3;
+
+static const char *optimizer_names[] = {
+    [PLAIN] = "PLAIN",
+    [MOMENTUM] = "MOMENTUM",
+    [NESTEROV] = "NESTEROV",
+    [RMSPROP] = "RMSPROP",
+    [ADAM] = "ADAM",
+};
+const int optimizer_name_count = 5;
+
+static const char *gradient_names[] = {
+    [ANALYTIC] = "ANALYTIC",
+    [NUMERIC] = "NUMERIC",
+};
+const int gradient_name_count = 2;
+
 static int find_id(char *name, const char *type, const char **array, int last)
 {
   int id;
@@ -363,8 +391,13 @@ static void sub_training_method_parser(network *nn, network_config *config, FILE
 	[GRADIENT_DESCENT]      = "GRADIENT_DESCENT",
 	[GENETIC_ALGORITHM]     = "GENETIC_ALGORITHM",
 	[MSMCO]                 = "MSMCO",
+	[LBFGS]                 = "LBFGS",
+	[LEVENBERG_MARQUARDT]   = "LEVENBERG_MARQUARDT",
+	[PARALLEL_TEMPERING]    = "PARALLEL_TEMPERING",
+	[INCREMENTAL_ANNEALING] = "INCREMENTAL_ANNEALING",
+	[GENETIC_TOURNAMENT]    = "GENETIC_TOURNAMENT",
   };
-  const int sub_method_token_count = 5;
+  const int sub_method_token_count = 10;
 
   int ret, method_id;
   char s[128];
@@ -409,6 +442,75 @@ static void sub_training_method_parser(network *nn, network_config *config, FILE
 	config->accuracy = eps;
 	};
 	break;
+  // parallel tempering (simulated annealing with replica exchange)
+  // syntax: verbosity replicas mmax nmax kbtmin kbtmax accuracy
+  // where
+  // verbosity = ON/OFF
+  // replicas  = number of chains, one temperature each
+  // mmax      = outer loop - number of exchange rounds
+  // nmax      = inner loop - number of test configurations of every chain per round
+  // kbtmin    = effective temperature of the coldest chain
+  // kbtmax    = effective temperature of the hottest chain
+  // accuracy  = numerical accuracy
+  case PARALLEL_TEMPERING: {
+	int verbosity = get_switch_value(fp, "verbosity");
+	int replicas = get_positive_number(fp, "parallel tempering replicas");
+	int mmax = get_positive_number(fp, "parallel tempering mmax");
+	int nmax = get_positive_number(fp, "parallel tempering nmax");
+	double kbtmin = get_double_positive_number(fp, "KBTMIN");
+	double kbtmax = get_double_positive_number(fp, "KBTMAX");
+	if (kbtmin >= kbtmax) {
+		printf("KBTMIN must be smaller then KBTMAX!\n");
+		exit(-1);
+	}
+	double eps = get_double_positive_number(fp, "ACCURACY");
+	printf("TRAINING METHOD = PARALLEL TEMPERING %d %d %d %g %g %g [OK]\n",
+		replicas, mmax, nmax, kbtmin, kbtmax, eps);
+	config->optimization_type = PARALLEL_TEMPERING;
+	config->verbosity = verbosity;
+	config->replicas = replicas;
+	config->mmax = mmax;
+	config->nmax = nmax;
+	config->kbtmin = kbtmin;
+	config->kbtmax = kbtmax;
+	config->accuracy = eps;
+	};
+	break;
+  // simulated annealing by moves of the weights of one neuron at a time
+  // syntax: verbosity mmax nmax kbtmin kbtmax accuracy
+  // where
+  // verbosity = ON/OFF
+  // mmax      = outer loop - number of effective temperature steps
+  // nmax      = inner loop - number of moves per temperature
+  // kbtmin    = effective temperature minimum
+  // kbtmax    = effective temperature maximum
+  // accuracy  = numerical accuracy
+  case INCREMENTAL_ANNEALING: {
+	int verbosity = get_switch_value(fp, "verbosity");
+	int mmax = get_positive_number(fp, "incremental annealing mmax");
+	if (mmax < 2) {
+		printf("MMAX must be greater than 1!\n");
+		exit(-1);
+	}
+	int nmax = get_positive_number(fp, "incremental annealing nmax");
+	double kbtmin = get_double_positive_number(fp, "KBTMIN");
+	double kbtmax = get_double_positive_number(fp, "KBTMAX");
+	if (kbtmin >= kbtmax) {
+		printf("KBTMIN must be smaller then KBTMAX!\n");
+		exit(-1);
+	}
+	double eps = get_double_positive_number(fp, "ACCURACY");
+	printf("TRAINING METHOD = INCREMENTAL ANNEALING %d %d %g %g %g [OK]\n",
+		mmax, nmax, kbtmin, kbtmax, eps);
+	config->optimization_type = INCREMENTAL_ANNEALING;
+	config->verbosity = verbosity;
+	config->mmax = mmax;
+	config->nmax = nmax;
+	config->kbtmin = kbtmin;
+	config->kbtmax = kbtmax;
+	config->accuracy = eps;
+	};
+	break;
   // random search
   // syntax: verbosity nmax accuracy
   // verbosity = ON/OFF
@@ -450,25 +552,50 @@ static void sub_training_method_parser(network *nn, network_config *config, FILE
 	};
 	break;
   // genetic algorithm
-  // syntax: verbosity nmax npop rate accuracy
+  // syntax: GENETIC_ALGORITHM  verbosity nmax npop rate accuracy
+  // or:     GENETIC_TOURNAMENT verbosity nmax npop offspring elite tournament rate accuracy
   // where:
-  // verbosity = ON/OFF
-  // nmax      = number of generations
-  // npop      = number of individuals per generation
-  // rate      = rate of change between one generation and the parent
-  // accuracy  = numerical accuracy
-  case GENETIC_ALGORITHM: {
+  // verbosity  = ON/OFF
+  // nmax       = number of generations
+  // npop       = number of individuals per generation
+  // offspring  = number of children per generation, at least npop - elite
+  //              (GENETIC_ALGORITHM: npop * (npop - 1), one per ordered pair of parents as the pool of old)
+  // elite      = number of best individuals carried over to the next generation (GENETIC_ALGORITHM: 1)
+  // tournament = number of individuals competing for every parent (GENETIC_ALGORITHM: 2)
+  // rate       = rate of change between one generation and the parent
+  // accuracy   = numerical accuracy
+  case GENETIC_ALGORITHM:
+  case GENETIC_TOURNAMENT: {
 	int verbosity = get_switch_value(fp, "verbosity");
 	int nmax = get_positive_number(fp, "genetic algorithm nmax");
-	int npop = get_positive_number(fp, "genetic algorithm npop");
+	int npop = get_strictly_positive_number(fp, "genetic algorithm npop");
+	int elite = MIN(1, npop - 1);
+	int offspring = MAX(npop * (npop - 1), npop - elite);
+	int tournament = 2;
+	if (method_id == GENETIC_TOURNAMENT) {
+		offspring = get_strictly_positive_number(fp, "genetic algorithm offspring");
+		elite = get_positive_number(fp, "genetic algorithm elite");
+		tournament = get_strictly_positive_number(fp, "genetic algorithm tournament");
+	}
 	double rate = get_double_positive_number(fp, "RATE");
 	double eps = get_double_positive_number(fp, "ACCURACY");
-	printf("OPTIMIZATION METHOD = GENETIC ALGORITHM %d %d %g %g [OK]\n",
-		nmax, npop, rate, eps);
+	if (elite >= npop) {
+		printf("ELITE must be smaller than NPOP!\n");
+		exit(-1);
+	}
+	if (offspring < npop - elite) {
+		printf("OFFSPRING must be at least NPOP - ELITE!\n");
+		exit(-1);
+	}
+	printf("OPTIMIZATION METHOD = GENETIC ALGORITHM %d %d %d %d %d %g %g [OK]\n",
+		nmax, npop, offspring, elite, tournament, rate, eps);
 	config->verbosity = verbosity;
 	config->optimization_type = GENETIC_ALGORITHM;
 	config->nmax = nmax;
 	config->npop = npop;
+	config->offspring = offspring;
+	config->elite = elite;
+	config->tournament = tournament;
 	config->rate = rate;
 	config->accuracy = eps;
 	};
@@ -494,6 +621,45 @@ static void sub_training_method_parser(network *nn, network_config *config, FILE
 	config->rate = rate;
 	};
 	break;
+  // limited memory BFGS
+  // syntax: verbosity memory maxiter accuracy
+  // where:
+  // verbosity = ON/OFF
+  // memory    = number of past iterations the curvature estimate is built from
+  // maxiter   = maximum number of iterations
+  // accuracy  = numerical accuracy
+  case LBFGS: {
+	int verbosity = get_switch_value(fp, "verbosity");
+	int memory  = get_positive_number(fp, "L-BFGS memory");
+	int maxiter = get_positive_number(fp, "L-BFGS MAXITER");
+	double eps = get_double_positive_number(fp, "ACCURACY");
+	printf("OPTIMIZATION METHOD = LBFGS %d %d %g [OK]\n",
+		memory, maxiter, eps);
+	config->verbosity = verbosity;
+	config->optimization_type = LBFGS;
+	config->memory = memory;
+	config->maxiter = maxiter;
+	config->accuracy = eps;
+	};
+	break;
+  // Levenberg-Marquardt (squared error only)
+  // syntax: verbosity maxiter accuracy
+  // where:
+  // verbosity = ON/OFF
+  // maxiter   = maximum number of iterations
+  // accuracy  = numerical accuracy
+  case LEVENBERG_MARQUARDT: {
+	int verbosity = get_switch_value(fp, "verbosity");
+	int maxiter = get_positive_number(fp, "Levenberg-Marquardt MAXITER");
+	double eps = get_double_positive_number(fp, "ACCURACY");
+	printf("OPTIMIZATION METHOD = LEVENBERG-MARQUARDT %d %g [OK]\n",
+		maxiter, eps);
+	config->verbosity = verbosity;
+	config->optimization_type = LEVENBERG_MARQUARDT;
+	config->maxiter = maxiter;
+	config->accuracy = eps;
+	};
+	break;
   default:
 	break;
   }
@@ -512,7 +678,7 @@ processing the input file\n\
  do{
   // read the current row
      ret = fscanf(fp,"%254s", s);
-     if (ret == 0)return;
+     if (ret <= 0)return;
 
   token_id = find_id(s, "Token", main_token_n, main_token_count);
 
@@ -711,6 +877,55 @@ processing the input file\n\
 	printf("ERROR_TYPE = %s [OK]\n", error_names[errtype]);
 	};
 	break;
+
+  // accuracy of the activation functions: EXACT (libm), FAST (absolute error below 1e-7) or FASTEST (below 1e-4)
+  // syntax: ACTIVATION_ACCURACY EXACT/FAST/FASTEST
+  case _ACTIVATION_ACCURACY: {
+	ret = fscanf(fp, "%254s", s);
+	int acc = find_id(s, main_token_n[token_id],
+		accuracy_names, accuracy_name_count);
+	config->activation_accuracy = acc;
+	printf("ACTIVATION_ACCURACY = %s [OK]\n", accuracy_names[acc]);
+	};
+	break;
+
+  // update rule of GRADIENT_DESCENT (see optimizer.h)
+  // syntax: GRADIENT_OPTIMIZER PLAIN
+  //         GRADIENT_OPTIMIZER MOMENTUM/NESTEROV momentum
+  //         GRADIENT_OPTIMIZER RMSPROP decay
+  //         GRADIENT_OPTIMIZER ADAM momentum decay
+  // where momentum and decay are the decay rates (below 1) of the running mean gradient and squared gradient
+  case _GRADIENT_OPTIMIZER: {
+	ret = fscanf(fp, "%254s", s);
+	int opt = find_id(s, main_token_n[token_id],
+		optimizer_names, optimizer_name_count);
+	double momentum = 0., decay = 0.;
+	if (opt == MOMENTUM || opt == NESTEROV || opt == ADAM)
+		momentum = get_double_positive_number(fp, "MOMENTUM");
+	if (opt == RMSPROP || opt == ADAM)
+		decay = get_double_positive_number(fp, "DECAY");
+	if (momentum >= 1. || decay >= 1.) {
+		printf("GRADIENT_OPTIMIZER decay rates must be smaller than 1!\n");
+		exit(-1);
+	}
+	config->optimizer = opt;
+	config->momentum = momentum;
+	config->decay = decay;
+	printf("GRADIENT_OPTIMIZER = %s %g %g [OK]\n", optimizer_names[opt], momentum, decay);
+	};
+	break;
+
+  // how GRADIENT_DESCENT gets the gradient
+  // syntax: GRADIENT ANALYTIC/NUMERIC
+  // where ANALYTIC is backpropagation and NUMERIC central differences with the step of the nxw grid
+  case _GRADIENT: {
+	ret = fscanf(fp, "%254s", s);
+	int grad = find_id(s, main_token_n[token_id],
+		gradient_names, gradient_name_count);
+	config->gradient = grad;
+	printf("GRADIENT = %s [OK]\n", gradient_names[grad]);
+	};
+	break;
     } /* close switch(token_id) */
   }
   sprintf(s,""); // empty the buffer
@@ -762,7 +977,7 @@ int NextCh(struct slidingbuffer *bf){assert(bf != NULL); if (ChAvailable(bf,1))
 // accept the specified number of characters updating the line & column counts.  Return #characters accepted.  Error messages give line numbers, so for verbose
 // debugging this routine outputs accepted lines prefixed with line numbers.
 int AcceptCh(struct slidingbuffer *bf, struct conf *config, int len){
-    assert(bf != NULL);  assert(config != NULL); assert(len > 0);
+    assert(bf != NULL);  assert(config != NULL); assert(len >= 0);
     char next;
     static int AnnouncedLineZero = 0;
     if (!AnnouncedLineZero++)printf("    0: ");
@@ -897,7 +1112,7 @@ int ReadQuotedString(struct slidingbuffer *bf, struct conf *config, char **retst
     assert(bf != NULL); assert(config != NULL);
     int allocsize = 0; char *retval = NULL;  *retstring = NULL;
     if (!AcceptToken(bf, config, "\"")) return (0);
-    for (int index = 0; 1 == 1; index++){
+    for (int index = 0; 1 == 1; ){
 	if (!ChAvailable(bf,1)) ErrStopParsing(bf, "While reading a string, reached end of input without finding a closing quote.", retval);
 	if (index + 3 >= allocsize){allocsize = MAX(allocsize * 2, 256); retval = (char*)realloc(retval, allocsize * sizeof(char)); //increase allocation.
 	    if (retval == NULL){fprintf(stderr, "Runtime Error: Allocation Failure(1) in ReadQuotedString\n"); exit(1);}}
@@ -963,9 +1178,9 @@ int ReadCreateNodeStmt(struct slidingbuffer *bf, struct conf *config, struct nne
     SkipToNext(bf, config); if (!AcceptToken(bf, config, ")")) ErrStopParsing(bf, "Expected Close Parenthesis",NULL);
     switch(in_hid_out){
     case 1: AddInputNodes(net, NumToCreate, Transfer, Accum, unitwidth );
-	if ((config->flags & SILENCE_RENUMBER) != 0 && net->nodecount > net->inputcount){
+	if ((config->flags & SILENCE_RENUMBER) != 0 && net->nodecount > net->inputcount+1){
 	    snprintf(warnstring, WARNSIZE,  "Warning: New Input nodes are numbered %d to %d.  Existing hidden and output nodes have been renumbered %d to %d.",
-		     net->inputcount - NumToCreate, net->inputcount-1, net->inputcount, net->nodecount-1);
+		     1 + net->inputcount - NumToCreate, net->inputcount, net->inputcount+1, net->nodecount-1);
 	    AddWarning(bf,warnstring);
 	}
 	break;
@@ -1095,14 +1310,30 @@ int ReadSaveStatement(struct slidingbuffer *bf, struct conf *config){
     }
 }
 
+// Accuracy(Exact), Accuracy(Fast), Accuracy(Fastest): accuracy of the transfer functions.  Exact uses the C library.  Fast
+// and Fastest use vectorized approximations with absolute error below 1e-7 and 1e-4 respectively.
+int ReadAccuracyStatement(struct slidingbuffer *bf, struct conf *config, struct nnet *net){
+    assert(bf != NULL); assert(config != NULL); assert(net != NULL);
+    if (!AcceptToken(bf, config, "Accuracy")) return(0);
+    SkipToNext(bf, config); if (!AcceptToken(bf, config, "(")) ErrStopParsing(bf, "Accuracy statements must be followed by '('", NULL);
+    SkipToNext(bf, config);
+    if (AcceptToken(bf, config, "Exact"))                net->accuracy = EXACT;
+    else if (AcceptToken(bf, config, "Fastest"))         net->accuracy = FASTEST;
+    else if (AcceptToken(bf, config, "Fast"))            net->accuracy = FAST;
+    else ErrStopParsing(bf, "Expected one of Exact, Fast, or Fastest.", NULL);
+    SkipToNext(bf, config); if (!AcceptToken(bf, config, ")")) ErrStopParsing(bf, "Expected ')' to close Accuracy statement.", NULL);
+    return(1);
+}
+
 // Silence statements
 // Save("string"), Save(Serialize),Save(#intermediate savefiles);
+// Accuracy(Exact/Fast/Fastest)
 int ReadConfigSection(struct slidingbuffer *bf, struct conf *config, struct nnet *net){
     assert(net != NULL); assert(config != NULL); assert(bf != NULL);
     SkipToNext(bf, config); if (!AcceptToken(bf, config, "StartConfig")) return (0);
     SkipToNext(bf, config);
-    while (ReadSilenceStatement(bf, config) || ReadSaveStatement(bf,config)) SkipToNext(bf, config);
-    if(!AcceptToken(bf, config, "EndConfig")) ErrStopParsing(bf,"Expected 'Silence', 'Save', or 'EndConfig'", NULL);
+    while (ReadSilenceStatement(bf, config) || ReadSaveStatement(bf,config) || ReadAccuracyStatement(bf, config, net)) SkipToNext(bf, config);
+    if(!AcceptToken(bf, config, "EndConfig")) ErrStopParsing(bf,"Expected 'Silence', 'Save', 'Accuracy', or 'EndConfig'", NULL);
     return(1);
 }
 
@@ -1206,10 +1437,10 @@ int ReadDataStatement(struct slidingbuffer *bf, struct conf *config, struct nnet
     if ((newdata->flags & DATA_DEPLOYMENT) != 0x0 && (newdata->outname == NULL))
         ErrStopParsing(bf, "There would be no point in Deployment if we didn't need the answers. Use 'ToFile/ToPipe' to say where to send them.", newdata);
     size_t casecount = 0;
-    if ((newdata->flags & DATA_IMMEDIATE) != 0x0) while (ReadImmediateCase(bf, config, newdata, casecount++));
+    if ((newdata->flags & DATA_IMMEDIATE) != 0x0) while (ReadImmediateCase(bf, config, newdata, casecount)) casecount++;
     newdata->entrycount = casecount;
-    newdata->data = (flotype *)realloc(newdata->data, casecount * sizeof(flotype) * (newdata->inputcount + newdata->outputcount));
-    if (newdata->data == NULL) {fprintf(stderr,"Runtime Error: Reallocation failure in ReadDataStatement.\n"); exit(1);}
+    if (casecount > 0) newdata->data = (flotype *)realloc(newdata->data, casecount * sizeof(flotype) * (newdata->inputcount + newdata->outputcount));
+    if (newdata->data == NULL && casecount > 0) {fprintf(stderr,"Runtime Error: Reallocation failure in ReadDataStatement.\n"); exit(1);}
     SkipToNext(bf,config); if (!AcceptToken(bf, config, ")")) ErrStopParsing(bf,"Close Parenthesis expected at end of Data Statement.", newdata);
     else net->data = newdata;
     return(1);
@@ -1284,7 +1515,7 @@ int ReadTrGoal(struct slidingbuffer *bf, struct conf *config, struct plans *pl){
 int ReadTrLearnRate(struct slidingbuffer *bf, struct conf *config, struct plans *pl){
     assert(bf != NULL); assert(config != NULL); assert(pl != NULL);
     if (!AcceptToken(bf, config, "LearningRate")) return (0); else SkipToNext(bf, config);
-    if(NumberAvailable(bf))pl->trainrate=ReadFloatingPoint(bf,config);else ErrStopParsing(bf,"A floating-point learning rate must follow 'TrainingGoal'.", NULL);
+    if(NumberAvailable(bf))pl->trainrate=ReadFloatingPoint(bf,config);else ErrStopParsing(bf,"A floating-point learning rate must follow 'LearningRate'.", NULL);
     return(1);
 }
 int ReadTrBatchSize(struct slidingbuffer *bf, struct conf *config,  struct plans *pl){
@@ -1295,43 +1526,87 @@ int ReadTrBatchSize(struct slidingbuffer *bf, struct conf *config,  struct plans
 }
 int ReadTrEpochSize(struct slidingbuffer *bf, struct conf *config, struct plans *pl){
     assert(bf != NULL); assert(config != NULL); assert(pl != NULL);
-    if (!AcceptToken(bf, config, "Goal")) return (0); else SkipToNext(bf, config);
-    if (NumberAvailable(bf)) pl->epochsize = ReadInteger(bf, config); else ErrStopParsing(bf, "A an integer number of batches must follow 'EpochSize'.", NULL);
+    if (!AcceptToken(bf, config, "EpochSize")) return (0); else SkipToNext(bf, config);
+    if (NumberAvailable(bf)) pl->epochsize = ReadInteger(bf, config); else ErrStopParsing(bf, "An integer number of batches must follow 'EpochSize'.", NULL);
+    return(1);
+}
+
+// the update rule of gradient descent: 'Momentum' or 'Nesterov' [momentum], 'RMSProp' [decay], 'Adam' [momentum [decay]].
+int ReadTrOptimizer(struct slidingbuffer *bf, struct conf *config, struct plans *pl){
+    assert(bf != NULL); assert(config != NULL); assert(pl != NULL);
+    if ((pl->planflags & PLAN_ALL_OPTIMIZERS) != 0 && (TokenAvailable(bf, "Momentum") || TokenAvailable(bf, "Nesterov") ||
+                                                      TokenAvailable(bf, "RMSProp") || TokenAvailable(bf, "Adam")))
+        ErrStopParsing(bf, "Only one of 'Momentum', 'Nesterov', 'RMSProp' and 'Adam' may be given.", NULL);
+    if (AcceptToken(bf, config, "Momentum"))       pl->planflags |= PLAN_MOMENTUM;
+    else if (AcceptToken(bf, config, "Nesterov"))  pl->planflags |= PLAN_NESTEROV;
+    else if (AcceptToken(bf, config, "RMSProp"))   pl->planflags |= PLAN_RMSPROP;
+    else if (AcceptToken(bf, config, "Adam"))      pl->planflags |= PLAN_ADAM;
+    else return(0);
+    SkipToNext(bf, config);
+    if ((pl->planflags & (PLAN_MOMENTUM | PLAN_NESTEROV | PLAN_ADAM)) != 0 && NumberAvailable(bf)){
+        pl->momentum = ReadFloatingPoint(bf, config); SkipToNext(bf, config);}
+    if ((pl->planflags & (PLAN_RMSPROP | PLAN_ADAM)) != 0 && NumberAvailable(bf)) pl->decay = ReadFloatingPoint(bf, config);
+    if (pl->momentum < ZERO || pl->momentum >= ONE || pl->decay < ZERO || pl->decay >= ONE)
+        ErrStopParsing(bf, "Momentum and decay rates must be at least zero and less than one.", NULL);
+    return(1);
+}
+
+// 'Workers' N: the number of processes to share the batches out among; 'Deterministic': sum the gradients in case order.
+int ReadTrWorkers(struct slidingbuffer *bf, struct conf *config, struct plans *pl){
+    assert(bf != NULL); assert(config != NULL); assert(pl != NULL);
+    if (AcceptToken(bf, config, "Deterministic")) {pl->planflags |= PLAN_DETERMINISTIC; return(1);}
+    if (!AcceptToken(bf, config, "Workers")) return (0); else SkipToNext(bf, config);
+    if (NumberAvailable(bf)) pl->workers = ReadInteger(bf, config); else ErrStopParsing(bf, "An integer number of processes must follow 'Workers'.", NULL);
     return(1);
 }
 
 int ReadGradientDescentArg(struct slidingbuffer *bf, struct conf *config, struct plans *pl){
     assert(bf != NULL); assert(config != NULL); assert(pl != NULL);
-    if (ReadTrBatchSize(bf, config, pl)||ReadTrLearnRate(bf, config, pl))return(1);
+    if (ReadTrBatchSize(bf, config, pl)||ReadTrEpochSize(bf, config, pl)||ReadTrLearnRate(bf, config, pl)||ReadTrOptimizer(bf, config, pl)
+        ||ReadTrWorkers(bf, config, pl))return(1);
+    return(0);
+}
+
+// Hogwild takes the arguments of gradient descent but the optimizer: its threads share nothing but the weights.
+int ReadHogwildArg(struct slidingbuffer *bf, struct conf *config, struct plans *pl){
+    assert(bf != NULL); assert(config != NULL); assert(pl != NULL);
+    if (ReadTrBatchSize(bf, config, pl)||ReadTrEpochSize(bf, config, pl)||ReadTrLearnRate(bf, config, pl))return(1);
     return(0);
 }
 
 
 int ReadTrainingPlan(struct slidingbuffer *bf, struct conf *config, struct nnet *net){
     assert(bf != NULL); assert(config != NULL); assert (net != NULL);
-    struct plans buf; struct plans *ret = &buf;
+    struct plans buf; struct plans *ret = &buf; bzero(&buf, sizeof(struct plans));
     if (!AcceptToken(bf, config, "TrainingPlan")) return(0); else SkipToNext(bf, config);
     ret->planflags |= PLAN_TRAIN;
     if (!AcceptToken(bf, config, "(")) ErrStopParsing(bf, "'TrainingPlan' must be followed by an open parenthesis.", NULL); else SkipToNext(bf, config);
     if (AcceptToken(bf, config, "GradientDescent")){ SkipToNext(bf,config);
         ret->batchsize = 1; ret->epochsize = PLAN_DEFAULT_EPOCHS; ret->goal = PLAN_DEFAULT_GOAL; ret->trainrate = PLAN_DEFAULT_RATE;
         ret->epochmax = PLAN_DEFAULT_MAXEP; ret->planflags |= PLAN_GRAD_DESCENT;
+        ret->momentum = PLAN_DEFAULT_MOMENTUM; ret->decay = PLAN_DEFAULT_DECAY;
         while (ReadGradientDescentArg(bf, config, ret) || ReadTrMaxEpochs(bf, config, ret) || ReadTrMinEpochs(bf, config, ret)
                || ReadTrReportFile(bf,config,ret)|| ReadTrGoal(bf,config,ret)) SkipToNext(bf,config);}
+    else if (AcceptToken(bf, config, "Hogwild")){ SkipToNext(bf,config);
+        ret->batchsize = 1; ret->epochsize = PLAN_DEFAULT_EPOCHS; ret->goal = PLAN_DEFAULT_GOAL; ret->trainrate = PLAN_DEFAULT_RATE;
+        ret->epochmax = PLAN_DEFAULT_MAXEP; ret->planflags |= PLAN_HOGWILD;
+        while (ReadHogwildArg(bf, config, ret) || ReadTrMaxEpochs(bf, config, ret) || ReadTrMinEpochs(bf, config, ret)
+               || ReadTrReportFile(bf,config,ret)|| ReadTrGoal(bf,config,ret)) SkipToNext(bf,config);}
     // else if (AcceptToken(bf, config, "Genetic")) etc...
-    else ErrStopParsing(bf, "Expected a training method to use. Methods available are: 'GradientDescent'.", NULL);
+    else ErrStopParsing(bf, "Expected a training method to use. Methods available are: 'GradientDescent' and 'Hogwild'.", NULL);
     SkipToNext(bf, config);
     if (!AcceptToken(bf, config, ")"))
-        ErrStopParsing(bf, "Expected 'TrainingGoal', 'LearningRate', 'BatchSize', 'EpochSize','ReportTo', 'MaxEpoch', 'MinEpoch', or closing parenthesis.", NULL);
+        ErrStopParsing(bf, "Expected 'TrainingGoal', 'LearningRate', 'BatchSize', 'EpochSize', 'Momentum', 'Nesterov', 'RMSProp', 'Adam', 'Workers', "
+                       "'Deterministic', 'ReportTo', 'MaxEpoch', 'MinEpoch', or closing parenthesis.", NULL);
     ret = (struct plans *)malloc(sizeof(struct plans));
     if (ret == NULL){fprintf(stderr, "Runtime Error: Allocation failure in ReadTrainingPlan.\n"); exit(1);}
-    memcpy((void *)&buf, (void *)ret, sizeof(struct plans));
+    memcpy((void *)ret, (void *)&buf, sizeof(struct plans));
     ret->next = net->plan; net->plan = ret;
     return(1);
 }
 int ReadTestingPlan(struct slidingbuffer *bf, struct conf *config, struct nnet *net){
     assert(bf != NULL); assert(config != NULL); assert (net != NULL);
-    struct plans buf; struct plans *ret = &buf;
+    struct plans buf; struct plans *ret = &buf; bzero(&buf, sizeof(struct plans));
     if (!AcceptToken(bf, config, "TestingPlan")) return(0); else SkipToNext(bf, config);
     ret->planflags = PLAN_TEST;
     if (!AcceptToken(bf, config, "(")) ErrStopParsing(bf, "'TestingPlan' must be followed by an open parenthesis.", NULL); else SkipToNext(bf, config);
@@ -1339,13 +1614,13 @@ int ReadTestingPlan(struct slidingbuffer *bf, struct conf *config, struct nnet *
     if (!AcceptToken(bf, config, ")")) ErrStopParsing(bf, "Testing Plans may have 'ReportTo' arguments, or end with closing parenthesis.", NULL);
     ret = (struct plans *)malloc(sizeof(struct plans));
     if (ret == NULL){fprintf(stderr, "Runtime Error: Allocation failure in ReadTestingPlan.\n"); exit(1);}
-    memcpy((void *)&buf, (void *)ret, sizeof(struct plans));
+    memcpy((void *)ret, (void *)&buf, sizeof(struct plans));
     ret->next = net->plan; net->plan = ret;
     return(1);
 }
 int ReadValidationPlan(struct slidingbuffer *bf, struct conf *config, struct nnet *net){
     assert(bf != NULL); assert(config != NULL); assert (net != NULL);
-    struct plans buf; struct plans *ret = &buf;
+    struct plans buf; struct plans *ret = &buf; bzero(&buf, sizeof(struct plans));
     if (!AcceptToken(bf, config, "ValidationPlan")) return(0); else SkipToNext(bf, config);
     ret->planflags |= PLAN_VALIDATE;
     if (!AcceptToken(bf, config, "(")) ErrStopParsing(bf, "'ValidationPlan' must be followed by an open parenthesis.", NULL); else SkipToNext(bf, config);
@@ -1353,13 +1628,13 @@ int ReadValidationPlan(struct slidingbuffer *bf, struct conf *config, struct nne
     if (!AcceptToken(bf, config, ")")) ErrStopParsing(bf, "Validation Plans may have 'ReportTo' arguments, or end with closing parenthesis.", NULL);
     ret = (struct plans *)malloc(sizeof(struct plans));
     if (ret == NULL){fprintf(stderr, "Runtime Error: Allocation failure in ReadValidationPlan.\n"); exit(1);}
-    memcpy((void *)&bf, (void *)ret, sizeof(struct plans));
+    memcpy((void *)ret, (void *)&buf, sizeof(struct plans));
     ret->next = net->plan; net->plan = ret;
     return(1);
 }
 int ReadDeploymentPlan(struct slidingbuffer *bf, struct conf *config, struct nnet *net){
     assert(bf != NULL); assert(config != NULL); assert (net != NULL);
-    struct plans buf; struct plans *ret = &buf;
+    struct plans buf; struct plans *ret = &buf; bzero(&buf, sizeof(struct plans));
     if (!AcceptToken(bf, config, "DeploymentPlan")) return(0); else SkipToNext(bf, config);
     ret->planflags |= PLAN_DEPLOY;
     if (!AcceptToken(bf, config, "(")) ErrStopParsing(bf, "'DeploymentPlan' must be followed by an open parenthesis.", NULL); else SkipToNext(bf, config);
@@ -1367,7 +1642,7 @@ int ReadDeploymentPlan(struct slidingbuffer *bf, struct conf *config, struct nne
     if (!AcceptToken(bf, config, ")")) ErrStopParsing(bf, "Deployment Plans may have 'ReportTo' arguments, and end with closing parenthesis.", NULL);
     ret = (struct plans *)malloc(sizeof(struct plans));
     if (ret == NULL){fprintf(stderr, "Runtime Error: Allocation failure in ReadDeploymentPlan.\n"); exit(1);}
-    memcpy((void *)&bf, (void *)ret, sizeof(struct plans));
+    memcpy((void *)ret, (void *)&buf, sizeof(struct plans));
     ret->next = net->plan; net->plan = ret;
     return(1);
 }
@@ -1468,7 +1743,7 @@ void debugnnet(struct nnet *net){
     printf("Nodes\n");
     for (count = 0; count < net->nodecount; count++){
 	if (count == 0) printf("   Bias Node 0: Always outputs one.\n");
-	else if (count < net->inputcount) printf("   Input ");
+	else if (count <= net->inputcount) printf("   Input ");
 	else if (count < net->nodecount-net->outputcount) printf("   Hidden ");
 	else printf("   Output ");
 	if (count != 0)
@@ -0,0 +1,195 @@
+/* plan.c -- This belongs to gneural_network
+
+   gneural_network is the GNU package which implements a programmable neural network.
+
+   Copyright (C) 2017 gneural_network developers
+
+   This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software
+   Foundation; either version 3, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// compiles a network into the flat execution plan used by feedforward() and error()
+
+#include "includes.h"
+#include "plan.h"
+#include "binom.h"
+#include "fact.h"
+
+static void *plan_alloc(size_t count, size_t size)
+{
+  void *p = calloc(count ? count : 1, size);
+  if (!p) {
+	printf("No memory available to compile the network!\n");
+	exit(-1);
+  }
+  return p;
+}
+
+void network_plan_free(network_plan *plan)
+{
+  if (!plan)
+	return;
+
+  free(plan->neuron);
+  free(plan->first);
+  free(plan->fanin);
+  free(plan->activation);
+  free(plan->accumulator);
+  free(plan->source);
+  free(plan->input);
+  free(plan->output);
+  free(plan->weights);
+  free(plan->act);
+  free(plan->batch);
+  free(plan->legendre);
+  free(plan->laguerre);
+  free(plan);
+}
+
+// fill the coefficient tables of the polynomial accumulators, with the same formulas feedforward() always used
+static void plan_polynomials(network_plan *plan)
+{
+  unsigned int i, j, s;
+
+  for (s = 0; s < plan->num_of_steps; ++s)
+	plan->max_fanin = MAX(plan->max_fanin, plan->fanin[s]);
+
+  plan->legendre = plan_alloc((size_t)plan->max_fanin * (plan->max_fanin + 1) / 2, sizeof(*plan->legendre));
+  plan->laguerre = plan_alloc((size_t)plan->max_fanin * (plan->max_fanin + 1) / 2, sizeof(*plan->laguerre));
+
+  for (i = 0; i < plan->max_fanin; ++i)
+	for (j = 0; j <= i; ++j) {
+	  plan->legendre[i * (i + 1) / 2 + j] = binom(i,j) * binom((i+j-1)/2,j) * pow(2, i);
+	  plan->laguerre[i * (i + 1) / 2 + j] = binom(i,j) * pow(-1,j) / fact(j);
+	}
+}
+
+network_plan *network_compile(network *nn)
+{
+  network_plan *plan;
+  unsigned int i, j, l, n, k, s;
+  uint32_t *offset;
+  unsigned char *ready;
+
+  if (!nn || !nn->num_of_neurons || !nn->num_of_layers)
+	return NULL;
+
+  plan = plan_alloc(1, sizeof(*plan));
+  plan->num_of_neurons = nn->num_of_neurons;
+
+  /* count the weights and remember where every neuron's weights start */
+  offset = plan_alloc(nn->num_of_neurons, sizeof(*offset));
+  for (k = 0, i = 0; i < nn->num_of_neurons; ++i) {
+	offset[i] = k;
+	k += nn->neurons[i].num_input;
+  }
+  plan->weight_count = k;
+
+  plan->weights = plan_alloc(plan->weight_count, sizeof(*plan->weights));
+  plan->source  = plan_alloc(plan->weight_count, sizeof(*plan->source));
+  plan->act     = plan_alloc(plan->num_of_neurons, sizeof(*plan->act));
+  plan->batch   = plan_alloc((size_t)plan->num_of_neurons * PLAN_BLOCK_CASES, sizeof(*plan->batch));
+
+  /* move the weights into the plan; the neurons keep pointing at them */
+  for (i = 0; i < nn->num_of_neurons; ++i) {
+	neuron *ne = &nn->neurons[i];
+	for (j = 0; j < ne->num_input; ++j) {
+	  plan->weights[offset[i] + j] = ne->w[j];
+	  plan->source[offset[i] + j] = ne->connection[j] ? ne->connection[j]->global_id : 0;
+	}
+	if (!nn->plan || ne->w < nn->plan->weights || ne->w >= nn->plan->weights + nn->plan->weight_count)
+	  free(ne->w);
+	ne->w = ne->num_input ? &plan->weights[offset[i]] : NULL;
+	plan->act[i] = ne->output;
+  }
+
+  /* one step per neuron of every layer but the first */
+  for (n = 0, l = 1; l < nn->num_of_layers; ++l)
+	n += nn->layers[l].num_of_neurons;
+  plan->num_of_steps = n;
+  plan->neuron      = plan_alloc(n, sizeof(*plan->neuron));
+  plan->first       = plan_alloc(n, sizeof(*plan->first));
+  plan->fanin       = plan_alloc(n, sizeof(*plan->fanin));
+  plan->activation  = plan_alloc(n, sizeof(*plan->activation));
+  plan->accumulator = plan_alloc(n, sizeof(*plan->accumulator));
+
+  for (s = 0, l = 1; l < nn->num_of_layers; ++l)
+	for (n = 0; n < nn->layers[l].num_of_neurons; ++n, ++s) {
+	  neuron *ne = &nn->layers[l].neurons[n];
+	  plan->neuron[s]      = ne->global_id;
+	  plan->first[s]       = offset[ne->global_id];
+	  plan->fanin[s]       = ne->num_input;
+	  plan->activation[s]  = ne->activation;
+	  plan->accumulator[s] = ne->accumulator;
+	}
+
+  plan->num_of_inputs = nn->layers[0].num_of_neurons;
+  plan->input = plan_alloc(plan->num_of_inputs, sizeof(*plan->input));
+  for (i = 0; i < plan->num_of_inputs; ++i)
+	plan->input[i] = nn->layers[0].neurons[i].global_id;
+
+  plan->num_of_outputs = nn->layers[nn->num_of_layers - 1].num_of_neurons;
+  plan->output = plan_alloc(plan->num_of_outputs, sizeof(*plan->output));
+  for (i = 0; i < plan->num_of_outputs; ++i)
+	plan->output[i] = nn->layers[nn->num_of_layers - 1].neurons[i].global_id;
+
+  plan_polynomials(plan);
+
+  /* a step that reads a neuron which is neither an input nor evaluated by an earlier step makes the plan recurrent */
+  ready = plan_alloc(plan->num_of_neurons, sizeof(*ready));
+  for (i = 0; i < plan->num_of_inputs; ++i)
+	ready[plan->input[i]] = 1;
+  for (s = 0; s < plan->num_of_steps; ++s) {
+	for (j = 0; j < plan->fanin[s]; ++j)
+	  if (!ready[plan->source[plan->first[s] + j]])
+		plan->recurrent = 1;
+	ready[plan->neuron[s]] = 1;
+  }
+
+  free(ready);
+  free(offset);
+  network_plan_free(nn->plan);
+  nn->plan = plan;
+  return plan;
+}
+
+network_context *network_context_new(network *nn)
+{
+  network_plan *plan = nn->plan != NULL ? nn->plan : network_compile(nn);
+  network_context *ctx;
+
+  if (!plan)
+	return NULL;
+
+  ctx = plan_alloc(1, sizeof(*ctx));
+  ctx->plan  = plan;
+  ctx->act   = plan_alloc(plan->num_of_neurons, sizeof(*ctx->act));
+  ctx->batch = plan_alloc((size_t)plan->num_of_neurons * PLAN_BLOCK_CASES, sizeof(*ctx->batch));
+  ctx->pre   = plan_alloc((size_t)plan->num_of_neurons * PLAN_BLOCK_CASES, sizeof(*ctx->pre));
+  ctx->delta = plan_alloc((size_t)plan->num_of_neurons * PLAN_BLOCK_CASES, sizeof(*ctx->delta));
+  memcpy(ctx->act, plan->act, plan->num_of_neurons * sizeof(*ctx->act));
+  return ctx;
+}
+
+void network_context_reset(network_context *ctx)
+{
+  if (ctx->plan->recurrent)
+	memcpy(ctx->act, ctx->plan->act, ctx->plan->num_of_neurons * sizeof(*ctx->act));
+}
+
+void network_context_free(network_context *ctx)
+{
+  if (!ctx)
+	return;
+
+  free(ctx->act);
+  free(ctx->batch);
+  free(ctx->pre);
+  free(ctx->delta);
+  free(ctx);
+}
@@ -26,3 +26,21 @@ inline double rnd(void) {
  return ISEED / 1048576.;
 }
 
+
+// returns a number between 0. and 1. (1. excluded) drawn from the state *seed of the caller (xorshift, period 2^32 - 1),
+// so that threads with a state each can draw their numbers independently. A zero state is replaced by a nonzero one.
+double rnd_r(unsigned int *seed) {
+ uint32_t x = *seed ? *seed : 38467;
+
+ x ^= x << 13;
+ x ^= x >> 17;
+ x ^= x << 5;
+ *seed = x;
+ return (x - 1) / 4294967296.;
+}
+
+// returns the starting state for rnd_r() of the stream number index (of a thread, a chain, a sample...), so that
+// streams with different numbers draw different numbers and every stream draws the same ones at every run.
+unsigned int rnd_seed(unsigned int index) {
+ return 38467u + 2654435761u * (index + 1);
+}
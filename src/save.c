@@ -161,12 +161,20 @@ void nnetwriter(struct nnet *net, struct conf *config, FILE *out){
             if (0 != (currentplan->planflags & PLAN_TRAIN)) {
                 fprintf(out, "    TrainingPlan(");
                 if (currentplan->planflags & PLAN_GRAD_DESCENT)       fprintf(out, "GradientDescent ");
+                else if (currentplan->planflags & PLAN_HOGWILD)       fprintf(out, "Hogwild ");
                 else {fprintf(stderr,"Program Error: Unhandled case(1) in nnetwriter.\n"); exit(1);}
                 if (currentplan->goal != PLAN_DEFAULT_GOAL)           fprintf(out, "TrainingGoal "FLOFMT" ", currentplan->goal);
                 if (currentplan->trainrate != PLAN_DEFAULT_RATE)      fprintf(out, "LearningRate "FLOFMT" ", currentplan->trainrate);
                 if (currentplan->batchsize != 1)                      fprintf(out, "BatchSize %d ", currentplan->batchsize);
-                if (currentplan->epochmin != 0)                       fprintf(out, "EpochMin %d ", currentplan->epochmin);
-                if (currentplan->epochmax != PLAN_DEFAULT_MAXEP)      fprintf(out, "EpochMax %d ", currentplan->epochmax);
+                if (currentplan->epochsize != PLAN_DEFAULT_EPOCHS)    fprintf(out, "EpochSize %d ", currentplan->epochsize);
+                if (currentplan->planflags & PLAN_MOMENTUM)           fprintf(out, "Momentum "FLOFMT" ", currentplan->momentum);
+                if (currentplan->planflags & PLAN_NESTEROV)           fprintf(out, "Nesterov "FLOFMT" ", currentplan->momentum);
+                if (currentplan->planflags & PLAN_RMSPROP)            fprintf(out, "RMSProp "FLOFMT" ", currentplan->decay);
+                if (currentplan->planflags & PLAN_ADAM)   fprintf(out, "Adam "FLOFMT" "FLOFMT" ", currentplan->momentum, currentplan->decay);
+                if (currentplan->workers > 1)                         fprintf(out, "Workers %u ", currentplan->workers);
+                if (currentplan->planflags & PLAN_DETERMINISTIC)      fprintf(out, "Deterministic ");
+                if (currentplan->epochmin != 0)                       fprintf(out, "MinEpoch %d ", currentplan->epochmin);
+                if (currentplan->epochmax != PLAN_DEFAULT_MAXEP)      fprintf(out, "MaxEpoch %d ", currentplan->epochmax);
                 if (currentplan->reportdest != NULL)                  fprintf(out, "ReportTo \"%s\" ", currentplan->reportdest);
                 fprintf(out, ")\n");
             }
@@ -192,7 +200,7 @@ void nnetwriter(struct nnet *net, struct conf *config, FILE *out){
 
     currentmask = (SILENCE_BIAS | SILENCE_DEBUG | SILENCE_ECHO | SILENCE_INPUT | SILENCE_OUTPUT | SILENCE_NODEINPUT |
                    SILENCE_NODEOUTPUT | SILENCE_MULTIACTIVATION | SILENCE_RECURRENCE | SILENCE_RENUMBER);
-    if ((config->flags & currentmask) != 0 || (config->flags & SAVE_DEFAULT) != 0){
+    if ((config->flags & currentmask) != 0 || (config->flags & SAVE_DEFAULT) != 0 || net->accuracy != EXACT){
         fprintf(out, "StartConfig\n");
         if ((config->flags & currentmask) != 0){
             fprintf(out, "    Silence( ");
@@ -214,28 +222,30 @@ void nnetwriter(struct nnet *net, struct conf *config, FILE *out){
             if (config->savecount != 0)fprintf(out, " %d", config->savecount);
             fprintf(out, ")\n");
         }
+        if (net->accuracy == FAST)                               fprintf(out, "    Accuracy(Fast)\n");
+        if (net->accuracy == FASTEST)                            fprintf(out, "    Accuracy(Fastest)\n");
         fprintf(out, "\nEndConfig\n");
     }
 
     fprintf(out, "StartNodes\n");
-    for (start = end = 1; net->inputcount > 0 && end < net->inputcount && end+1 < net->nodecount; start=++end){
+    for (start = end = 1; net->inputcount > 0 && end <= net->inputcount && end < net->nodecount; start=++end){
 	acc = net->accum[start]; xfer = net->transfer[start]; width = net->transferwidths[start];
 	while(end<net->inputcount && 1+end<net->nodecount && net->accum[end+1]==acc && net->transfer[end+1]==xfer && net->transferwidths[end+1]==width) end++;
-	if (width == 1) fprintf(out,"    CreateInput( %d, %s, %s)\n",1+end-start, acctokens[acc], outtokens[xfer] );
-	else fprintf(out,"    CreateInput( %d, %s, %s, %d)\n",1+end-start, acctokens[acc], outtokens[xfer], width);
+	if (width == 1) fprintf(out,"    CreateInput( %d %s %s)\n",1+end-start, acctokens[acc], outtokens[xfer] );
+	else fprintf(out,"    CreateInput( %d %s %s %d)\n",1+end-start, acctokens[acc], outtokens[xfer], width);
     }
-    for (; net->nodecount > 2 && end < net->nodecount - net->outputcount && end+1 < net->nodecount; start=++end){
+    for (; end < net->nodecount - net->outputcount; start=++end){
 	acc = net->accum[start]; xfer = net->transfer[start]; width = net->transferwidths[start];
 	while(end+1 < net->nodecount - net->outputcount && end + 1 < net->nodecount && net->accum[end+1]==acc && net->transfer[end+1]==xfer &&
 	      net->transferwidths[end+1]==width) end++;
-	if (width == 1) fprintf(out,"    CreateHidden( %d, %s, %s)\n",1+end-start, acctokens[acc], outtokens[xfer] );
-	else fprintf(out,"    CreateHidden( %d, %s, %s, %d)\n",1+end-start, acctokens[acc], outtokens[xfer], width);
+	if (width == 1) fprintf(out,"    CreateHidden( %d %s %s)\n",1+end-start, acctokens[acc], outtokens[xfer] );
+	else fprintf(out,"    CreateHidden( %d %s %s %d)\n",1+end-start, acctokens[acc], outtokens[xfer], width);
     }
     for (start=end; end < net->nodecount; start=++end){
 	acc = net->accum[start]; xfer = net->transfer[start]; width = net->transferwidths[start];
 	while(end+1 < net->nodecount && net->accum[end+1]==acc && net->transfer[end+1]==xfer && net->transferwidths[end+1]==width) end++;
-	if (width == 1) fprintf(out,"    CreateOutput( %d, %s, %s)\n", 1+end-start, acctokens[acc], outtokens[xfer]);
-	else fprintf(out,"    CreateOutput( %d, %s, %s, %d)\n",1+end-start, acctokens[acc], outtokens[xfer], width);
+	if (width == 1) fprintf(out,"    CreateOutput( %d %s %s)\n", 1+end-start, acctokens[acc], outtokens[xfer]);
+	else fprintf(out,"    CreateOutput( %d %s %s %d)\n",1+end-start, acctokens[acc], outtokens[xfer], width);
     }
     fprintf(out, "EndNodes\n");
 
@@ -269,7 +279,7 @@ void nnetwriter(struct nnet *net, struct conf *config, FILE *out){
                 if (start != end) {
                     fprintf(out, "[");
                     for (nex = start; nex <= end; nex++) fprintf(out, FLOFMT" ", net->weights[nex]); fprintf(out, "])\n");}
-                else fprintf(out, FLOFMT"\n", net->weights[start] );
+                else fprintf(out, FLOFMT")\n", net->weights[start] );
                 if (end == net->synapsecount) state = 4;                     else {state = 0; conn = end+1;}
             case 4: break;
             default: {fprintf(stderr, "Program Error: Unhandled case(2) in nnetwriter.\n"); exit(1);}
@@ -0,0 +1,108 @@
+/* schedule.c -- This belongs to gneural_network
+
+   gneural_network is the GNU package which implements a programmable neural network.
+
+   Copyright (C) 2017 gneural_network developers
+
+   This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software
+   Foundation; either version 3, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// level schedule of a feedforward nnet, used by fwdprop() to evaluate independent nodes in parallel
+
+#include "includes.h"
+#include "schedule.h"
+
+static void *schedule_alloc(size_t count, size_t size){
+    void *p = calloc(count ? count : 1, size);
+    if (p == NULL) {fprintf(stderr, "No memory available to schedule the network.\n"); exit(1);}
+    return p;
+}
+
+void nnet_schedule_free(struct nnet_schedule *sched){
+    if (sched == NULL) return;
+    free(sched->levels);  free(sched->groups);  free(sched->work);
+    free(sched->first);   free(sched->synapses);  free(sched->sources);  free(sched->weights);
+    free(sched);
+}
+
+void nnet_schedule_weights(const struct nnet *net){
+    assert(net != NULL);
+    struct nnet_schedule *sched = net->schedule;
+    if (sched == NULL) return;
+    for (unsigned int pos = 0; pos < sched->first[net->nodecount]; pos++) sched->weights[pos] = net->weights[sched->synapses[pos]];
+}
+
+struct nnet_schedule *nnet_schedule(const struct nnet *net){
+    assert(net != NULL);
+    struct nnet_schedule *sched;
+    unsigned int node, syn, lev, maxsource = 0;
+    unsigned int *leader, *level, *fill;
+
+    if (net->nodecount < 2) return NULL;
+    // leader[n] is the first node of the transfer group holding node n, walking the groups the way fwdprop does.
+    leader = schedule_alloc(net->nodecount, sizeof(unsigned int));
+    for (node = 1; node < net->nodecount; ){
+	for (unsigned int member = node; member < node + net->transferwidths[node] && member < net->nodecount; member++)
+	    leader[member] = node;
+	node += net->transferwidths[node];
+    }
+    // a synapse into a group that has already fired by the time fwdprop reaches it makes the network recurrent.
+    for (syn = 0; syn < net->synapsecount; syn++){
+	maxsource = MAX(maxsource, net->sources[syn]);
+	if (net->dests[syn] != 0 && leader[net->dests[syn]] <= maxsource) {free(leader); return NULL;}
+    }
+
+    sched = schedule_alloc(1, sizeof(struct nnet_schedule));
+    // bucket the synapses by destination; a stable counting sort keeps the script order within each destination.
+    sched->first = schedule_alloc(net->nodecount + 1, sizeof(unsigned int));
+    sched->synapses = schedule_alloc(net->synapsecount, sizeof(unsigned int));
+    for (syn = 0; syn < net->synapsecount; syn++)
+	if (net->dests[syn] != 0) sched->first[net->dests[syn] + 1]++;
+    for (node = 0; node < net->nodecount; node++) sched->first[node + 1] += sched->first[node];
+    fill = schedule_alloc(net->nodecount, sizeof(unsigned int));
+    memcpy(fill, sched->first, sizeof(unsigned int) * net->nodecount);
+    for (syn = 0; syn < net->synapsecount; syn++)
+	if (net->dests[syn] != 0) sched->synapses[fill[net->dests[syn]]++] = syn;
+    sched->sources = schedule_alloc(net->synapsecount, sizeof(unsigned int));
+    sched->weights = schedule_alloc(net->synapsecount, sizeof(flotype));
+    for (unsigned int pos = 0; pos < sched->first[net->nodecount]; pos++){
+	sched->sources[pos] = net->sources[sched->synapses[pos]];
+	sched->weights[pos] = net->weights[sched->synapses[pos]];
+    }
+
+    // levels, kept per group (level[leader]). Every source belongs to a group wholly before the group it feeds, so one
+    // pass in node order sees the final level of each source first.
+    level = schedule_alloc(net->nodecount, sizeof(unsigned int));
+    for (node = 1; node < net->nodecount; node++){
+	for (unsigned int pos = sched->first[node]; pos < sched->first[node + 1]; pos++){
+	    unsigned int source = sched->sources[pos];
+	    if (source != 0) level[leader[node]] = MAX(level[leader[node]], level[leader[source]] + 1);
+	}
+	sched->levelcount = MAX(sched->levelcount, level[leader[node]] + 1);
+    }
+
+    // groups, bucketed by level the same way.
+    sched->levels = schedule_alloc(sched->levelcount + 1, sizeof(unsigned int));
+    sched->work = schedule_alloc(sched->levelcount, sizeof(unsigned int));
+    for (node = 1; node < net->nodecount; node++){
+	sched->work[level[leader[node]]] += 1 + sched->first[node + 1] - sched->first[node];
+	if (leader[node] == node) {sched->levels[level[node] + 1]++; sched->groupcount++;}
+    }
+    for (lev = 0; lev < sched->levelcount; lev++){
+	sched->levels[lev + 1] += sched->levels[lev];
+	sched->widest = MAX(sched->widest, sched->work[lev]);
+    }
+    sched->groups = schedule_alloc(sched->groupcount, sizeof(unsigned int));
+    memcpy(fill, sched->levels, sizeof(unsigned int) * sched->levelcount);
+    for (node = 1; node < net->nodecount; node++)
+	if (leader[node] == node) sched->groups[fill[level[node]]++] = node;
+
+    free(level); free(fill); free(leader);
+    return sched;
+}
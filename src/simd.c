@@ -0,0 +1,317 @@
+/* simd.c -- This belongs to gneural_network
+
+   gneural_network is the GNU package which implements a programmable neural network.
+
+   Copyright (C) 2017 gneural_network developers
+
+   This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software
+   Foundation; either version 3, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// dot product, axpy and weight update kernels, selected at run time according to the instruction sets of the CPU
+
+#include "simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_X86 1
+#endif
+
+/*
+ * scalar versions: used on every CPU without a vector version and until simd_init() is called
+ */
+static double dot_gather_scalar(unsigned int n, const double *w, const double *x, const uint32_t *idx){
+ unsigned int i;
+ double sum = 0.;
+ for (i = 0; i < n; i++)
+  sum += w[i] * x[idx[i]];
+ return sum;
+}
+
+static void axpy_scalar(unsigned int n, double a, const double *x, double *y){
+ unsigned int i;
+ for (i = 0; i < n; i++)
+  y[i] += a * x[i];
+}
+
+static void momentum_step_scalar(unsigned int n, const double *g, double scale, double mu, double a, double b, double *m,
+                                 double *w){
+ unsigned int i;
+ double gi;
+ for (i = 0; i < n; i++) {
+  gi = scale * g[i];
+  m[i] = mu * m[i] + gi;
+  w[i] -= a * gi + b * m[i];
+ }
+}
+
+static void adaptive_step_scalar(unsigned int n, const double *g, double scale, double beta1, double beta2, double a,
+                                 double b, double eps, double *m, double *v, double *w){
+ unsigned int i;
+ double gi;
+ for (i = 0; i < n; i++) {
+  gi = scale * g[i];
+  m[i] = beta1 * m[i] + (1. - beta1) * gi;
+  v[i] = beta2 * v[i] + (1. - beta2) * gi * gi;
+  w[i] -= (a * gi + b * m[i]) / (sqrt(v[i]) + eps);
+ }
+}
+
+#ifdef SIMD_X86
+
+/*
+ * SSE2: two lanes, the gather is done with two scalar loads
+ */
+__attribute__((target("sse2")))
+static double dot_gather_sse2(unsigned int n, const double *w, const double *x, const uint32_t *idx){
+ unsigned int i = 0;
+ __m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd();
+ double r[2];
+ double sum;
+
+ for (; i + 4 <= n; i += 4) {
+  s0 = _mm_add_pd(s0, _mm_mul_pd(_mm_loadu_pd(&w[i]), _mm_set_pd(x[idx[i + 1]], x[idx[i]])));
+  s1 = _mm_add_pd(s1, _mm_mul_pd(_mm_loadu_pd(&w[i + 2]), _mm_set_pd(x[idx[i + 3]], x[idx[i + 2]])));
+ }
+ _mm_storeu_pd(r, _mm_add_pd(s0, s1));
+ sum = r[0] + r[1];
+ for (; i < n; i++)
+  sum += w[i] * x[idx[i]];
+ return sum;
+}
+
+__attribute__((target("sse2")))
+static void axpy_sse2(unsigned int n, double a, const double *x, double *y){
+ unsigned int i = 0;
+ __m128d va = _mm_set1_pd(a);
+
+ for (; i + 2 <= n; i += 2)
+  _mm_storeu_pd(&y[i], _mm_add_pd(_mm_loadu_pd(&y[i]), _mm_mul_pd(va, _mm_loadu_pd(&x[i]))));
+ for (; i < n; i++)
+  y[i] += a * x[i];
+}
+
+__attribute__((target("sse2")))
+static void momentum_step_sse2(unsigned int n, const double *g, double scale, double mu, double a, double b, double *m,
+                               double *w){
+ unsigned int i = 0;
+ __m128d vs = _mm_set1_pd(scale), vmu = _mm_set1_pd(mu), va = _mm_set1_pd(a), vb = _mm_set1_pd(b);
+
+ for (; i + 2 <= n; i += 2) {
+  __m128d gi = _mm_mul_pd(vs, _mm_loadu_pd(&g[i]));
+  __m128d mi = _mm_add_pd(_mm_mul_pd(vmu, _mm_loadu_pd(&m[i])), gi);
+  _mm_storeu_pd(&m[i], mi);
+  _mm_storeu_pd(&w[i], _mm_sub_pd(_mm_loadu_pd(&w[i]), _mm_add_pd(_mm_mul_pd(va, gi), _mm_mul_pd(vb, mi))));
+ }
+ momentum_step_scalar(n - i, &g[i], scale, mu, a, b, &m[i], &w[i]);
+}
+
+__attribute__((target("sse2")))
+static void adaptive_step_sse2(unsigned int n, const double *g, double scale, double beta1, double beta2, double a,
+                               double b, double eps, double *m, double *v, double *w){
+ unsigned int i = 0;
+ __m128d vs = _mm_set1_pd(scale), vb1 = _mm_set1_pd(beta1), vc1 = _mm_set1_pd(1. - beta1);
+ __m128d vb2 = _mm_set1_pd(beta2), vc2 = _mm_set1_pd(1. - beta2);
+ __m128d va = _mm_set1_pd(a), vb = _mm_set1_pd(b), veps = _mm_set1_pd(eps);
+
+ for (; i + 2 <= n; i += 2) {
+  __m128d gi = _mm_mul_pd(vs, _mm_loadu_pd(&g[i]));
+  __m128d mi = _mm_add_pd(_mm_mul_pd(vb1, _mm_loadu_pd(&m[i])), _mm_mul_pd(vc1, gi));
+  __m128d vi = _mm_add_pd(_mm_mul_pd(vb2, _mm_loadu_pd(&v[i])), _mm_mul_pd(vc2, _mm_mul_pd(gi, gi)));
+  __m128d step = _mm_div_pd(_mm_add_pd(_mm_mul_pd(va, gi), _mm_mul_pd(vb, mi)), _mm_add_pd(_mm_sqrt_pd(vi), veps));
+  _mm_storeu_pd(&m[i], mi);
+  _mm_storeu_pd(&v[i], vi);
+  _mm_storeu_pd(&w[i], _mm_sub_pd(_mm_loadu_pd(&w[i]), step));
+ }
+ adaptive_step_scalar(n - i, &g[i], scale, beta1, beta2, a, b, eps, &m[i], &v[i], &w[i]);
+}
+
+/*
+ * AVX2: four lanes, hardware gather and fused multiply-add
+ */
+__attribute__((target("avx2,fma")))
+static double dot_gather_avx2(unsigned int n, const double *w, const double *x, const uint32_t *idx){
+ unsigned int i = 0;
+ __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+ __m128d h;
+ double sum;
+
+ for (; i + 8 <= n; i += 8) {
+  __m128i i0 = _mm_loadu_si128((const __m128i *)&idx[i]);
+  __m128i i1 = _mm_loadu_si128((const __m128i *)&idx[i + 4]);
+  s0 = _mm256_fmadd_pd(_mm256_loadu_pd(&w[i]), _mm256_i32gather_pd(x, i0, 8), s0);
+  s1 = _mm256_fmadd_pd(_mm256_loadu_pd(&w[i + 4]), _mm256_i32gather_pd(x, i1, 8), s1);
+ }
+ s0 = _mm256_add_pd(s0, s1);
+ h = _mm_add_pd(_mm256_castpd256_pd128(s0), _mm256_extractf128_pd(s0, 1));
+ sum = _mm_cvtsd_f64(_mm_add_sd(h, _mm_unpackhi_pd(h, h)));
+ for (; i < n; i++)
+  sum += w[i] * x[idx[i]];
+ return sum;
+}
+
+__attribute__((target("avx2,fma")))
+static void axpy_avx2(unsigned int n, double a, const double *x, double *y){
+ unsigned int i = 0;
+ __m256d va = _mm256_set1_pd(a);
+
+ for (; i + 4 <= n; i += 4)
+  _mm256_storeu_pd(&y[i], _mm256_fmadd_pd(va, _mm256_loadu_pd(&x[i]), _mm256_loadu_pd(&y[i])));
+ for (; i < n; i++)
+  y[i] += a * x[i];
+}
+
+__attribute__((target("avx2,fma")))
+static void momentum_step_avx2(unsigned int n, const double *g, double scale, double mu, double a, double b, double *m,
+                               double *w){
+ unsigned int i = 0;
+ __m256d vs = _mm256_set1_pd(scale), vmu = _mm256_set1_pd(mu), va = _mm256_set1_pd(a), vb = _mm256_set1_pd(b);
+
+ for (; i + 4 <= n; i += 4) {
+  __m256d gi = _mm256_mul_pd(vs, _mm256_loadu_pd(&g[i]));
+  __m256d mi = _mm256_fmadd_pd(vmu, _mm256_loadu_pd(&m[i]), gi);
+  _mm256_storeu_pd(&m[i], mi);
+  _mm256_storeu_pd(&w[i], _mm256_fnmadd_pd(va, gi, _mm256_fnmadd_pd(vb, mi, _mm256_loadu_pd(&w[i]))));
+ }
+ momentum_step_scalar(n - i, &g[i], scale, mu, a, b, &m[i], &w[i]);
+}
+
+__attribute__((target("avx2,fma")))
+static void adaptive_step_avx2(unsigned int n, const double *g, double scale, double beta1, double beta2, double a,
+                               double b, double eps, double *m, double *v, double *w){
+ unsigned int i = 0;
+ __m256d vs = _mm256_set1_pd(scale), vb1 = _mm256_set1_pd(beta1), vc1 = _mm256_set1_pd(1. - beta1);
+ __m256d vb2 = _mm256_set1_pd(beta2), vc2 = _mm256_set1_pd(1. - beta2);
+ __m256d va = _mm256_set1_pd(a), vb = _mm256_set1_pd(b), veps = _mm256_set1_pd(eps);
+
+ for (; i + 4 <= n; i += 4) {
+  __m256d gi = _mm256_mul_pd(vs, _mm256_loadu_pd(&g[i]));
+  __m256d mi = _mm256_fmadd_pd(vb1, _mm256_loadu_pd(&m[i]), _mm256_mul_pd(vc1, gi));
+  __m256d vi = _mm256_fmadd_pd(vb2, _mm256_loadu_pd(&v[i]), _mm256_mul_pd(vc2, _mm256_mul_pd(gi, gi)));
+  __m256d step = _mm256_div_pd(_mm256_fmadd_pd(va, gi, _mm256_mul_pd(vb, mi)), _mm256_add_pd(_mm256_sqrt_pd(vi), veps));
+  _mm256_storeu_pd(&m[i], mi);
+  _mm256_storeu_pd(&v[i], vi);
+  _mm256_storeu_pd(&w[i], _mm256_sub_pd(_mm256_loadu_pd(&w[i]), step));
+ }
+ adaptive_step_scalar(n - i, &g[i], scale, beta1, beta2, a, b, eps, &m[i], &v[i], &w[i]);
+}
+
+/*
+ * AVX-512: eight lanes, the tails of axpy and of the weight updates are handled with a mask
+ */
+__attribute__((target("avx512f")))
+static double dot_gather_avx512(unsigned int n, const double *w, const double *x, const uint32_t *idx){
+ unsigned int i = 0;
+ __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+ double sum;
+
+ for (; i + 16 <= n; i += 16) {
+  __m256i i0 = _mm256_loadu_si256((const __m256i *)&idx[i]);
+  __m256i i1 = _mm256_loadu_si256((const __m256i *)&idx[i + 8]);
+  s0 = _mm512_fmadd_pd(_mm512_loadu_pd(&w[i]), _mm512_i32gather_pd(i0, x, 8), s0);
+  s1 = _mm512_fmadd_pd(_mm512_loadu_pd(&w[i + 8]), _mm512_i32gather_pd(i1, x, 8), s1);
+ }
+ if (i + 8 <= n) {
+  __m256i i0 = _mm256_loadu_si256((const __m256i *)&idx[i]);
+  s0 = _mm512_fmadd_pd(_mm512_loadu_pd(&w[i]), _mm512_i32gather_pd(i0, x, 8), s0);
+  i += 8;
+ }
+ sum = _mm512_reduce_add_pd(_mm512_add_pd(s0, s1));
+ for (; i < n; i++)
+  sum += w[i] * x[idx[i]];
+ return sum;
+}
+
+__attribute__((target("avx512f")))
+static void axpy_avx512(unsigned int n, double a, const double *x, double *y){
+ unsigned int i = 0;
+ __m512d va = _mm512_set1_pd(a);
+
+ for (; i + 8 <= n; i += 8)
+  _mm512_storeu_pd(&y[i], _mm512_fmadd_pd(va, _mm512_loadu_pd(&x[i]), _mm512_loadu_pd(&y[i])));
+ if (i < n) {
+  __mmask8 m = (__mmask8)((1u << (n - i)) - 1);
+  _mm512_mask_storeu_pd(&y[i], m, _mm512_fmadd_pd(va, _mm512_maskz_loadu_pd(m, &x[i]), _mm512_maskz_loadu_pd(m, &y[i])));
+ }
+}
+
+__attribute__((target("avx512f")))
+static void momentum_step_avx512(unsigned int n, const double *g, double scale, double mu, double a, double b, double *m,
+                                 double *w){
+ unsigned int i = 0;
+ __m512d vs = _mm512_set1_pd(scale), vmu = _mm512_set1_pd(mu), va = _mm512_set1_pd(a), vb = _mm512_set1_pd(b);
+
+ for (; i < n; i += 8) {
+  __mmask8 k = (n - i >= 8) ? (__mmask8)0xff : (__mmask8)((1u << (n - i)) - 1);
+  __m512d gi = _mm512_mul_pd(vs, _mm512_maskz_loadu_pd(k, &g[i]));
+  __m512d mi = _mm512_fmadd_pd(vmu, _mm512_maskz_loadu_pd(k, &m[i]), gi);
+  _mm512_mask_storeu_pd(&m[i], k, mi);
+  _mm512_mask_storeu_pd(&w[i], k, _mm512_fnmadd_pd(va, gi, _mm512_fnmadd_pd(vb, mi, _mm512_maskz_loadu_pd(k, &w[i]))));
+ }
+}
+
+__attribute__((target("avx512f")))
+static void adaptive_step_avx512(unsigned int n, const double *g, double scale, double beta1, double beta2, double a,
+                                 double b, double eps, double *m, double *v, double *w){
+ unsigned int i = 0;
+ __m512d vs = _mm512_set1_pd(scale), vb1 = _mm512_set1_pd(beta1), vc1 = _mm512_set1_pd(1. - beta1);
+ __m512d vb2 = _mm512_set1_pd(beta2), vc2 = _mm512_set1_pd(1. - beta2);
+ __m512d va = _mm512_set1_pd(a), vb = _mm512_set1_pd(b), veps = _mm512_set1_pd(eps);
+
+ for (; i < n; i += 8) {
+  __mmask8 k = (n - i >= 8) ? (__mmask8)0xff : (__mmask8)((1u << (n - i)) - 1);
+  __m512d gi = _mm512_mul_pd(vs, _mm512_maskz_loadu_pd(k, &g[i]));
+  __m512d mi = _mm512_fmadd_pd(vb1, _mm512_maskz_loadu_pd(k, &m[i]), _mm512_mul_pd(vc1, gi));
+  __m512d vi = _mm512_fmadd_pd(vb2, _mm512_maskz_loadu_pd(k, &v[i]), _mm512_mul_pd(vc2, _mm512_mul_pd(gi, gi)));
+  __m512d step = _mm512_div_pd(_mm512_fmadd_pd(va, gi, _mm512_mul_pd(vb, mi)), _mm512_add_pd(_mm512_sqrt_pd(vi), veps));
+  _mm512_mask_storeu_pd(&m[i], k, mi);
+  _mm512_mask_storeu_pd(&v[i], k, vi);
+  _mm512_mask_storeu_pd(&w[i], k, _mm512_sub_pd(_mm512_maskz_loadu_pd(k, &w[i]), step));
+ }
+}
+
+#endif
+
+double (*simd_dot_gather)(unsigned int, const double *, const double *, const uint32_t *) = dot_gather_scalar;
+void (*simd_axpy)(unsigned int, double, const double *, double *) = axpy_scalar;
+void (*simd_momentum_step)(unsigned int, const double *, double, double, double, double, double *, double *) =
+ momentum_step_scalar;
+void (*simd_adaptive_step)(unsigned int, const double *, double, double, double, double, double, double, double *, double *,
+                           double *) = adaptive_step_scalar;
+
+const char *simd_init(void){
+#ifdef SIMD_X86
+ __builtin_cpu_init();
+ if (__builtin_cpu_supports("avx512f")) {
+  simd_dot_gather = dot_gather_avx512;
+  simd_axpy = axpy_avx512;
+  simd_momentum_step = momentum_step_avx512;
+  simd_adaptive_step = adaptive_step_avx512;
+  return "AVX-512";
+ }
+ if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+  simd_dot_gather = dot_gather_avx2;
+  simd_axpy = axpy_avx2;
+  simd_momentum_step = momentum_step_avx2;
+  simd_adaptive_step = adaptive_step_avx2;
+  return "AVX2";
+ }
+ if (__builtin_cpu_supports("sse2")) {
+  simd_dot_gather = dot_gather_sse2;
+  simd_axpy = axpy_sse2;
+  simd_momentum_step = momentum_step_sse2;
+  simd_adaptive_step = adaptive_step_sse2;
+  return "SSE2";
+ }
+#endif
+ simd_dot_gather = dot_gather_scalar;
+ simd_axpy = axpy_scalar;
+ simd_momentum_step = momentum_step_scalar;
+ simd_adaptive_step = adaptive_step_scalar;
+ return "scalar";
+}
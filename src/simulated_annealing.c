@@ -22,6 +22,7 @@
 #include "randomize.h"
 #include "rnd.h"
 #include "includes.h"
+#include "plan.h"
 
 void simulated_annealing(network *nn, network_config *config) {
  int output = config->verbosity;	/* screen output - on/off */
@@ -31,36 +32,26 @@ void simulated_annealing(network *nn, network_config *config) {
  double kbtmax = config->kbtmax;	/* effective temperature maximum */
  double eps = config->accuracy;
  register int m,n;
- int i;
  double err;
  double e0;
  double de;
  double kbt;
  double e_best;
- double **w_total;
- double **wbackup;
- double **wbest;
- void *tmp;
+ double *w = nn->plan->weights;	/* all the weights of the network (see plan.h) */
+ size_t size_ = nn->plan->weight_count * sizeof(double);
+ double *w_total;
+ double *wbackup;
+ double *wbest;
 
- w_total = malloc(nn->num_of_neurons * sizeof(double*) * 2);
+ w_total = malloc(size_ * 2 + 1);
 
  if (w_total == NULL){
-	printf("SA: Not enough memory to allocate\ndouble **w_total\n");
+	printf("SA: Not enough memory to allocate\ndouble *w_total\n");
 	exit(-1);
  }
 
  wbackup = w_total;
- wbest   = w_total + nn->num_of_neurons;
-
- for (i = 0; i < nn->num_of_neurons; ++i) {
-	unsigned long size_ = nn->neurons[i].num_input * sizeof(double);
-	wbackup[i] = malloc(size_);
-	wbest[i]   = malloc(size_);
-	if (!wbackup[i] || !wbest[i]) {
-		printf("SA: Not enough memory to allocate\ndouble *wbackup/*wbest #%d\n", i);
-		exit(-1);
-	}
- }
+ wbest   = w_total + nn->plan->weight_count;
 
  e_best = err = e0 = 1.e8; // just a big number
 
@@ -70,13 +61,7 @@ void simulated_annealing(network *nn, network_config *config) {
 
   for (n = 0;(n < nmax) && (e0 > eps);n++){
    // backup the old weights
-   /* for each neurons */
-   for (i = 0; i < nn->num_of_neurons; i++) {
-	/* for each input in the neuron swap the weight buffers */
-	tmp = nn->neurons[i].w;
-	nn->neurons[i].w = wbackup[i];
-	wbackup[i] = tmp;
-   }
+   memcpy(wbackup, w, size_);
    // new random configuration
    randomize(nn, config);
    // compute the error
@@ -93,24 +78,13 @@ void simulated_annealing(network *nn, network_config *config) {
 	e0 = err;
     else
      // reject the new configuration
-     /* for each neurons */
-     for (i = 0; i < nn->num_of_neurons; i++) {
-	/* swap the weights */
-	tmp = wbackup[i];
-	wbackup[i] = nn->neurons[i].w;
-	nn->neurons[i].w = tmp;
-     }
+     memcpy(w, wbackup, size_);
    } else
 	// accept the new configuration
 	e0 = err;
 
    if (e_best > e0) {
-    /* for each neurons */
-    for (i = 0; i < nn->num_of_neurons; i++) {
-      tmp = wbest[i];
-      wbest[i] = nn->neurons[i].w;
-      nn->neurons[i].w = tmp;
-    }
+    memcpy(wbest, w, size_);
     e_best = e0;
    }
   }
@@ -119,17 +93,248 @@ void simulated_annealing(network *nn, network_config *config) {
  }
 
  // keep the best solution found
- /* for each neurons */
- for (i = 0; i < nn->num_of_neurons; i++) {
-   tmp = nn->neurons[i].w;
-   nn->neurons[i].w = wbest[i];
-   wbest[i] = tmp;
- }
+ memcpy(w, wbest, size_);
 
   if (output == ON)
     printf("\n");
-  for (i = 0; i < nn->num_of_neurons * 2; i++)
-    free(w_total[i]);
 
    free(w_total);
 }
+
+// one replica of parallel tempering: a chain of weight configurations at the fixed temperature kbt, with its own
+// weights, random state and evaluation context. The best configuration the chain has visited is kept in wbest.
+typedef struct {
+ double kbt;
+ double step;		/* half width of the moves */
+ double e0;		/* error of w */
+ double e_best;		/* error of wbest */
+ double *w, *wtry, *wbest;
+ unsigned int seed;
+ network_context *ctx;
+} replica;
+
+// nmax Metropolis moves of a replica. A move shifts every weight by a uniform amount of at most step, kept within
+// [wmin, wmax], and is taken with probability exp(-de/kbt). A recurrent network starts every move from its own state,
+// so that the errors of all the chains stay comparable at the exchanges.
+static void replica_moves(replica *r, unsigned int n, int nmax, network_config *config) {
+ double err, de;
+ unsigned int k;
+ int m;
+
+ for (m = 0; (m < nmax) && (r->e_best > config->accuracy); m++) {
+  for (k = 0; k < n; k++)
+   r->wtry[k] = MIN(config->wmax, MAX(config->wmin, r->w[k] + r->step * (2. * rnd_r(&r->seed) - 1.)));
+  network_context_reset(r->ctx);
+  err = error_context(r->ctx, r->wtry, config);
+  de = err - r->e0;
+  if (de <= 0. || rnd_r(&r->seed) < exp(-de / r->kbt)) {
+   double *tmp = r->w;
+   r->w = r->wtry;
+   r->wtry = tmp;
+   r->e0 = err;
+   if (r->e0 < r->e_best) {
+    memcpy(r->wbest, r->w, n * sizeof(double));
+    r->e_best = r->e0;
+   }
+  }
+ }
+}
+
+// parallel tempering (replica exchange): 'replicas' chains at temperatures in geometric progression from kbtmin to
+// kbtmax run side by side, one per thread, for mmax rounds of nmax moves. Hot chains make wide moves and cross
+// barriers, cold ones narrow moves that settle into minima. After every round neighbouring chains offer to swap
+// configurations, with probability min(1, exp((e_i - e_j) (1/kbt_i - 1/kbt_j))), which lets the good configurations
+// the hot chains find go down the ladder. Every chain draws from a random state of its own, so the result does not
+// depend on the number of threads. The network ends up with the best configuration any chain visited.
+void parallel_tempering(network *nn, network_config *config) {
+ int output = config->verbosity;	/* screen output - on/off */
+ int replicas = config->replicas;	/* number of chains */
+ int mmax = config->mmax;		/* outer loop - number of exchange rounds */
+ int nmax = config->nmax;		/* inner loop - number of moves of every chain per round */
+ double kbtmin = config->kbtmin;	/* effective temperature of the coldest chain */
+ double kbtmax = config->kbtmax;	/* effective temperature of the hottest chain */
+ double eps = config->accuracy;
+ network_plan *plan = nn->plan != NULL ? nn->plan : network_compile(nn);
+ unsigned int n = plan->weight_count;
+ unsigned int seed = 38467;		/* random state of the exchanges */
+ replica *r;
+ double *buffers;
+ double e_best;
+ int k, m, best;
+
+ r = malloc(replicas * sizeof(replica));
+ buffers = malloc((size_t)replicas * 3 * n * sizeof(double) + 1);
+ if (r == NULL || buffers == NULL) {
+  printf("PT: Not enough memory to allocate\nreplica *r, double *buffers\n");
+  exit(-1);
+ }
+
+ // every chain starts from the weights of the network
+ for (k = 0; k < replicas; k++) {
+  r[k].kbt = replicas > 1 ? kbtmin * pow(kbtmax / kbtmin, (double)k / (replicas - 1)) : kbtmin;
+  r[k].step = 0.5 * (config->wmax - config->wmin) * r[k].kbt / kbtmax;
+  r[k].w = buffers + (size_t)3 * k * n;
+  r[k].wtry = r[k].w + n;
+  r[k].wbest = r[k].wtry + n;
+  r[k].seed = rnd_seed(k);
+  r[k].ctx = network_context_new(nn);
+  memcpy(r[k].w, plan->weights, n * sizeof(double));
+  memcpy(r[k].wbest, plan->weights, n * sizeof(double));
+  network_context_reset(r[k].ctx);
+  r[k].e_best = r[k].e0 = error_context(r[k].ctx, r[k].w, config);
+ }
+
+ e_best = r[0].e_best;
+ best = 0;
+ for (m = 0; (m < mmax) && (e_best > eps); m++) {
+#pragma omp parallel for schedule(dynamic, 1) num_threads(MIN(replicas, omp_get_max_threads()))
+  for (k = 0; k < replicas; k++)
+   replica_moves(&r[k], n, nmax, config);
+
+  // neighbours offer to swap, even pairs after even rounds and odd pairs after odd ones
+  for (k = m % 2; k + 1 < replicas; k += 2) {
+   double x = (r[k].e0 - r[k + 1].e0) * (1. / r[k].kbt - 1. / r[k + 1].kbt);
+   if (x >= 0. || rnd_r(&seed) < exp(x)) {
+    double *w = r[k].w, e0 = r[k].e0;
+    r[k].w = r[k + 1].w;
+    r[k].e0 = r[k + 1].e0;
+    r[k + 1].w = w;
+    r[k + 1].e0 = e0;
+   }
+  }
+
+  for (k = 0; k < replicas; k++)
+   if (r[k].e_best < e_best) {
+    e_best = r[k].e_best;
+    best = k;
+   }
+  if (output == ON)
+    printf("PT: %d %g\n", m, e_best);
+ }
+
+ // keep the best solution found
+ memcpy(plan->weights, r[best].wbest, n * sizeof(double));
+
+ if (output == ON)
+   printf("\n");
+
+ for (k = 0; k < replicas; k++)
+  network_context_free(r[k].ctx);
+ free(buffers);
+ free(r);
+}
+
+// simulated annealing by small moves: a move shifts the input weights of one neuron, picked at random, by a uniform
+// amount of at most 0.5 (wmax - wmin) kbt / kbtmax, kept within [wmin, wmax], and is taken with probability
+// exp(-de/kbt). The temperature goes down from kbtmax to kbtmin as in simulated_annealing. The outputs of every
+// neuron for every training case are kept from one move to the next (see error_cached), so a move only evaluates
+// the neuron it changed and the neurons downstream of it. A recurrent network carries state from one case to the
+// next, which the kept outputs do not: it is rejected.
+void incremental_annealing(network *nn, network_config *config) {
+ int output = config->verbosity;	/* screen output - on/off */
+ int mmax = config->mmax;		/* outer loop - number of effective temperature steps */
+ int nmax = config->nmax;		/* inner loop - number of moves per temperature */
+ double kbtmin = config->kbtmin;	/* effective temperature minimum */
+ double kbtmax = config->kbtmax;	/* effective temperature maximum */
+ double eps = config->accuracy;
+ network_plan *plan = nn->plan != NULL ? nn->plan : network_compile(nn);
+ const unsigned int block = PLAN_BLOCK_CASES;
+ unsigned int nblocks = (config->num_cases + block - 1) / block;
+ size_t size_ = (size_t)nblocks * plan->num_of_neurons * block;	/* doubles in a copy of the outputs */
+ double *w = plan->weights;		/* all the weights of the network (see plan.h) */
+ double *cache, *trial;			/* outputs with the current weights, and with the weights of the move */
+ double *wbackup, *wbest;
+ uint32_t *affected;			/* steps evaluated by a move, in evaluation order */
+ unsigned int seed = rnd_seed(0);	/* random state of the moves */
+ unsigned char *marked;			/* neurons changed by a move */
+ unsigned int s, t, i, b, naffected, first, fanin;
+ double err, e0, de, kbt, step, e_best;
+ register int m, n;
+
+ if (plan->recurrent) {
+  printf("ISA: the network is recurrent, and the error of a move can not be computed incrementally!\n");
+  exit(-1);
+ }
+ cache = malloc(sizeof(double) * size_ * 2 + 1);
+ wbackup = malloc(sizeof(double) * (plan->max_fanin + plan->weight_count) + 1);
+ affected = malloc(sizeof(uint32_t) * plan->num_of_steps + 1);
+ marked = malloc(plan->num_of_neurons + 1);
+ if (cache == NULL || wbackup == NULL || affected == NULL || marked == NULL) {
+  printf("ISA: Not enough memory to allocate\ndouble *cache, *wbackup, uint32_t *affected, unsigned char *marked\n");
+  exit(-1);
+ }
+ trial = cache + size_;
+ wbest = wbackup + plan->max_fanin;
+
+ e_best = e0 = error_cached(plan, w, cache, config, NULL, 0);
+ memcpy(trial, cache, sizeof(double) * size_);
+ memcpy(wbest, w, sizeof(double) * plan->weight_count);
+
+ for (m = 0; (m < mmax) && (e_best > eps); m++) {
+
+  kbt = kbtmax - m * (kbtmax - kbtmin) / (mmax - 1);
+  step = 0.5 * (config->wmax - config->wmin) * kbt / kbtmax;
+
+  for (n = 0; (n < nmax) && (e_best > eps) && (plan->num_of_steps > 0); n++) {
+   // move the input weights of one neuron
+   s = MIN((unsigned int)(rnd_r(&seed) * plan->num_of_steps), plan->num_of_steps - 1);
+   first = plan->first[s];
+   fanin = plan->fanin[s];
+   memcpy(wbackup, &w[first], sizeof(double) * fanin);
+   for (i = 0; i < fanin; i++)
+    w[first + i] = MIN(config->wmax, MAX(config->wmin, w[first + i] + step * (2. * rnd_r(&seed) - 1.)));
+
+   // the steps downstream of it: those reading a neuron already changed (the plan is not recurrent, so a step only
+   // reads the inputs and the neurons of the steps before it)
+   memset(marked, 0, plan->num_of_neurons);
+   marked[plan->neuron[s]] = 1;
+   affected[0] = s;
+   naffected = 1;
+   for (t = s + 1; t < plan->num_of_steps; t++)
+    for (i = 0; i < plan->fanin[t]; i++)
+     if (marked[plan->source[plan->first[t] + i]]) {
+      marked[plan->neuron[t]] = 1;
+      affected[naffected++] = t;
+      break;
+     }
+
+   err = error_cached(plan, w, trial, config, affected, naffected);
+   de = err - e0;
+   if (de <= 0. || rnd_r(&seed) < exp(-de / kbt)) {
+    // accept the move: keep its outputs
+    e0 = err;
+    for (b = 0; b < nblocks; b++)
+     for (t = 0; t < naffected; t++) {
+      size_t row = ((size_t)b * plan->num_of_neurons + plan->neuron[affected[t]]) * block;
+      memcpy(&cache[row], &trial[row], sizeof(double) * block);
+     }
+    if (e_best > e0) {
+     memcpy(wbest, w, sizeof(double) * plan->weight_count);
+     e_best = e0;
+    }
+   }
+   else {
+    // reject the move: back to the old weights and outputs
+    memcpy(&w[first], wbackup, sizeof(double) * fanin);
+    for (b = 0; b < nblocks; b++)
+     for (t = 0; t < naffected; t++) {
+      size_t row = ((size_t)b * plan->num_of_neurons + plan->neuron[affected[t]]) * block;
+      memcpy(&trial[row], &cache[row], sizeof(double) * block);
+     }
+   }
+  }
+  if (output == ON)
+    printf("ISA: %d %g %g\n", m, kbt, e_best);
+ }
+
+ // keep the best solution found
+ memcpy(w, wbest, sizeof(double) * plan->weight_count);
+
+ if (output == ON)
+   printf("\n");
+
+ free(cache);
+ free(wbackup);
+ free(affected);
+ free(marked);
+}
@@ -0,0 +1,381 @@
+/* train.c -- This belongs to gneural_network
+
+   gneural_network is the GNU package which implements a programmable neural network.
+
+   Copyright (C) 2017 gneural_network developers
+
+   This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software
+   Foundation; either version 3, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// execution of the plans of an nnet script.
+
+// A Training plan runs mini-batch gradient descent. The cases of every Training data statement are streamed in script
+// order, wrapping around at the end, BatchSize cases to a batch (zero: all of them). backprop() sums the gradient of the
+// squared error over the batch and the weights then move against its mean: by LearningRate times the mean, or by the
+// update of the Momentum, Nesterov, RMSProp or Adam optimizer (see optimizer.h) if the plan names one. An epoch is
+// EpochSize batches (zero: one pass over the cases). Training ends after the first epoch, MinEpoch or later, whose
+// accuracy reaches the TrainingGoal, or after MaxEpoch epochs (zero: no limit).
+
+// A Hogwild plan runs the same stochastic gradient descent asynchronously: the batches of an epoch are a queue every
+// thread takes the next batch from, and a thread moves the shared weights by LearningRate times the mean gradient of its
+// batch as soon as it has it, with no lock and no wait for the others. Each weight change is an atomic add, so none is
+// lost, but the other threads read the weights while they change: a case may see some updates of a concurrent batch
+// and not others. That race is the method; its updates are sparse enough in large networks that it costs little
+// accuracy, and the threads only meet at the end of each epoch. Recurrent networks carry state from one case to the next
+// and are trained by a single thread.
+
+// Workers(N) shares every batch of a GradientDescent plan out among N processes forked on this host. Each runs its own
+// contiguous share of the cases of the batch, the gradients meet in shared memory, and every process sums a share of
+// the synapses over all of them. All the processes then take the same optimizer step with the same sums, so their
+// weights stay identical. Without Deterministic each process adds its cases into one gradient; with it every batch is
+// cut into the same DETERMINISTIC_CHUNKS runs of consecutive cases (fewer if the batch is smaller) whatever the number
+// of processes, each run adds up its cases in order into a gradient of its own, and the runs are summed in order: the
+// training is then the same to the last bit whatever the number of processes or threads. Recurrent networks depend on
+// the order of their cases and are trained by one process.
+
+#include "includes.h"
+#include "train.h"
+#include "feedforward.h"
+#include "backprop.h"
+#include "schedule.h"
+#include "optimizer.h"
+#include "workers.h"
+
+#define DETERMINISTIC_CHUNKS 64 /* gradients kept per batch by a Deterministic plan, so shared memory does not grow with
+                                   the batch */
+
+// what a thread needs to run cases through the network. Each thread sums the gradients of its cases separately.
+struct trainer{
+    flotype *activations;  // nodecount
+    flotype *history;      // HISTORYSIZE(net)
+    flotype *delta;        // 2 * nodecount, scratch for backprop()
+    flotype *outputs;      // outputcount network outputs, then outputcount derivatives of the error by them
+    flotype *gradient;     // synapsecount
+};
+
+static void *train_alloc(size_t count, size_t size){
+    void *p = calloc(count ? count : 1, size);
+    if (p == NULL) {fprintf(stderr, "No memory available to train the network.\n"); exit(1);}
+    return p;
+}
+
+// one case: its inputs, then its target outputs. Adds the gradient of the case to the trainer's and returns the squared
+// error. Recurrent networks keep their activations from one case to the next.
+static flotype train_case(const struct nnet *net, const flotype *example, struct trainer *tr, int reset){
+    flotype *const outerr = &(tr->outputs[net->outputcount]);
+    flotype sse = ZERO;
+    if (reset) init_activations(net, tr->activations);
+    fwdprop(net, example, tr->activations, tr->history, tr->outputs);
+    for (size_t count = 0; count < net->outputcount; count++){
+	outerr[count] = tr->outputs[count] - example[net->inputcount + count];
+	sse += outerr[count] * outerr[count];
+    }
+    backprop(net, tr->history, outerr, tr->delta, tr->gradient);
+    return sse;
+}
+
+// run 'batch' cases, starting at case 'next' of the list, and return their summed squared error. The cases of a
+// feedforward network do not depend on each other, so a batch that pays for it is shared out among the threads.
+static flotype train_batch(const struct nnet *net, const flotype *const *examples, size_t casecount, size_t next,
+			   size_t batch, struct trainer *trainers, int threads){
+    const int feedforward = (net->schedule != NULL);
+    flotype sse = ZERO;
+    if (feedforward && PAR_WORTH(batch * (net->synapsecount + net->nodecount))){
+#pragma omp parallel num_threads(threads) reduction(+:sse)
+	{
+	    struct trainer *tr = &(trainers[omp_get_thread_num()]);
+#pragma omp for schedule(static)
+	    for (size_t count = 0; count < batch; count++) sse += train_case(net, examples[(next + count) % casecount], tr, 1);
+	}
+    }
+    else for (size_t count = 0; count < batch; count++) sse += train_case(net, examples[(next + count) % casecount], trainers, feedforward);
+    return sse;
+}
+
+// gather the gradient sums of the other threads into the first thread's, clearing them for the next batch.
+static void gather_gradient(const struct nnet *net, struct trainer *trainers, int threads){
+    flotype *const gradient = trainers[0].gradient;
+    if (PAR_WORTH((size_t)net->synapsecount * threads)){
+#pragma omp parallel for
+	for (size_t syn = 0; syn < net->synapsecount; syn++)
+	    for (int thread = 1; thread < threads; thread++) {gradient[syn] += trainers[thread].gradient[syn]; trainers[thread].gradient[syn] = ZERO;}
+    }
+    else for (size_t syn = 0; syn < net->synapsecount; syn++)
+	for (int thread = 1; thread < threads; thread++) {gradient[syn] += trainers[thread].gradient[syn]; trainers[thread].gradient[syn] = ZERO;}
+}
+
+// one Hogwild epoch of 'batches' batches from case 'next' on, by 'threads' threads (one for a recurrent network); returns
+// the summed squared error. position[syn] is the place of synapse syn among the schedule's weights, which fwdprop reads,
+// so they are updated along with net->weights.
+static flotype hogwild_epoch(struct nnet *net, const flotype *const *examples, size_t casecount, size_t next, size_t batchsize,
+			     size_t batches, struct trainer *trainers, int threads, const unsigned int *position, flotype rate){
+    struct nnet_schedule *const sched = net->schedule;
+    const int feedforward = (sched != NULL);
+    const flotype step = -rate / batchsize;
+    size_t taken = 0;
+    flotype sse = ZERO;
+#pragma omp parallel num_threads(threads) reduction(+:sse)
+    {
+	struct trainer *tr = &(trainers[omp_get_thread_num()]);
+	for (;;){
+	    size_t batch;
+#pragma omp atomic capture
+	    batch = taken++;
+	    if (batch >= batches) break;
+	    for (size_t count = 0; count < batchsize; count++)
+		sse += train_case(net, examples[(next + batch * batchsize + count) % casecount], tr, feedforward);
+	    for (size_t syn = 0; syn < net->synapsecount; syn++){
+		if (tr->gradient[syn] == ZERO) continue;
+		const flotype change = step * tr->gradient[syn];
+		tr->gradient[syn] = ZERO;
+#pragma omp atomic
+		net->weights[syn] += change;
+		if (feedforward){
+#pragma omp atomic
+		    sched->weights[position[syn]] += change;
+		}
+	    }
+	}
+    }
+    // the two copies saw the same changes, but maybe not in the same order: make them agree to the last bit again
+    nnet_schedule_weights(net);
+    return sse;
+}
+
+// one batch of 'batch' cases shared out among the worker processes of 'group'. shared holds 'slots' gradients (one per
+// process, or one per chunk of the batch if deterministic), then their squared errors, then the summed gradient, which
+// is left there for the step. Returns the summed squared error of the batch.
+static flotype workers_batch(const struct nnet *net, const flotype *const *examples, size_t casecount, size_t next,
+			     size_t batch, struct trainer *trainers, int threads, struct workers *group, flotype *shared,
+			     size_t slots, int deterministic){
+    const size_t synapses = net->synapsecount, chunks = MIN(batch, DETERMINISTIC_CHUNKS);
+    const size_t used = deterministic ? chunks : (size_t)group->active;
+    flotype *const gradients = shared, *const errors = &(shared[slots * synapses]), *const sum = &(errors[slots]);
+    const size_t first = batch * group->rank / group->active, last = batch * (group->rank + 1) / group->active;
+    flotype sse = ZERO;
+
+    if (deterministic){
+	// this process's chunks, each added up in case order by one thread
+	const long from = chunks * group->rank / group->active, to = chunks * (group->rank + 1) / group->active;
+#pragma omp parallel for schedule(dynamic, 1) num_threads(threads) if (PAR_WORTH((last - first) * (synapses + net->nodecount)))
+	for (long chunk = from; chunk < to; chunk++){
+	    struct trainer tr = trainers[omp_get_thread_num()];
+	    flotype chunksse = ZERO;
+	    tr.gradient = &(gradients[chunk * synapses]);
+	    memset(tr.gradient, 0, sizeof(flotype) * synapses);
+	    for (size_t count = batch * chunk / chunks; count < batch * (chunk + 1) / chunks; count++)
+		chunksse += train_case(net, examples[(next + count) % casecount], &tr, 1);
+	    errors[chunk] = chunksse;
+	}
+    }
+    else {
+	errors[group->rank] = train_batch(net, examples, casecount, next + first, last - first, trainers, threads);
+	gather_gradient(net, trainers, threads);
+	memcpy(&(gradients[group->rank * synapses]), trainers[0].gradient, sizeof(flotype) * synapses);
+	memset(trainers[0].gradient, 0, sizeof(flotype) * synapses);
+    }
+    workers_barrier(group);
+    // the gradients are summed in slot order, each process doing its own range of synapses
+    for (size_t syn = synapses * group->rank / group->active; syn < synapses * (group->rank + 1) / group->active; syn++){
+	flotype total = ZERO;
+	for (size_t slot = 0; slot < used; slot++) total += gradients[slot * synapses + syn];
+	sum[syn] = total;
+    }
+    for (size_t slot = 0; slot < used; slot++) sse += errors[slot];
+    workers_barrier(group);
+    return sse;
+}
+
+static enum gradient_optimizer plan_optimizer(const struct plans *plan){
+    if ((plan->planflags & PLAN_MOMENTUM) != 0) return MOMENTUM;
+    if ((plan->planflags & PLAN_NESTEROV) != 0) return NESTEROV;
+    if ((plan->planflags & PLAN_RMSPROP) != 0) return RMSPROP;
+    if ((plan->planflags & PLAN_ADAM) != 0) return ADAM;
+    return PLAIN;
+}
+
+// Training data statements give complete cases with the network's widths; those are the ones training can use.
+static int training_data(const struct nnet *net, const struct cases *data){
+    return ((data->flags & DATA_TRAINING) != 0 && data->data != NULL &&
+	    data->inputcount == net->inputcount && data->outputcount == net->outputcount);
+}
+
+// the plans a group of worker processes trains: those with Workers or Deterministic, of feedforward networks
+static int shared_plan(const struct nnet *net, const struct plans *plan){
+    return ((plan->planflags & PLAN_TRAIN) != 0 && (plan->planflags & PLAN_HOGWILD) == 0 && net->schedule != NULL &&
+	    (plan->workers > 1 || (plan->planflags & PLAN_DETERMINISTIC) != 0));
+}
+
+// the shared memory a plan needs, after the weights handed to the workers (see runplans): 'slots' gradients and their
+// squared errors, then the summed gradient (see workers_batch)
+static size_t plan_slots(const struct plans *plan, size_t batchsize){
+    if ((plan->planflags & PLAN_DETERMINISTIC) != 0) return MIN(batchsize != 0 ? batchsize : DETERMINISTIC_CHUNKS, DETERMINISTIC_CHUNKS);
+    return MAX(plan->workers, 1);
+}
+
+flotype nnettrain(struct nnet *net, const struct plans *plan, struct workers *group){
+    assert(net != NULL); assert(plan != NULL);
+    const struct cases *data;
+    const flotype **examples;
+    struct trainer *trainers;
+    optimizer *opt;
+    unsigned int *position = NULL;
+    const int hogwild = (plan->planflags & PLAN_HOGWILD) != 0;
+    int hogthreads = 1;
+    flotype *shared = NULL;
+    size_t slots = 0;
+    const int deterministic = (plan->planflags & PLAN_DETERMINISTIC) != 0;
+    FILE *report = NULL;
+    size_t casecount = 0, next = 0, batchsize, batches, pos;
+    unsigned int epoch;
+    int threads = omp_get_max_threads();
+    flotype sse, accuracy = ZERO;
+    double start = omp_get_wtime();
+
+    for (data = net->data; data != NULL; data = data->next) if (training_data(net, data)) casecount += data->entrycount;
+    if (casecount == 0 || net->outputcount == 0){
+	fprintf(stderr, "A Training plan needs Training data with cases of %d inputs and %d outputs.\n", net->inputcount, net->outputcount);
+	exit(1);
+    }
+    // data statements are listed latest first; put their cases back in script order.
+    examples = train_alloc(casecount, sizeof(flotype *));
+    for (pos = casecount, data = net->data; data != NULL; data = data->next)
+	if (training_data(net, data)){
+	    pos -= data->entrycount;
+	    for (size_t entry = 0; entry < data->entrycount; entry++)
+		examples[pos + entry] = &(data->data[entry * (data->inputcount + data->outputcount)]);
+	}
+    batchsize = plan->batchsize != 0 ? plan->batchsize : casecount;
+    batches = plan->epochsize != 0 ? plan->epochsize : (casecount + batchsize - 1) / batchsize;
+
+    trainers = train_alloc(threads, sizeof(struct trainer));
+    for (int thread = 0; thread < threads; thread++){
+	trainers[thread].activations = train_alloc(net->nodecount, sizeof(flotype));
+	trainers[thread].history = train_alloc(HISTORYSIZE(net), sizeof(flotype));
+	trainers[thread].delta = train_alloc(2 * (size_t)net->nodecount, sizeof(flotype));
+	trainers[thread].outputs = train_alloc(2 * (size_t)net->outputcount, sizeof(flotype));
+	trainers[thread].gradient = train_alloc(net->synapsecount, sizeof(flotype));
+    }
+    init_activations(net, trainers[0].activations);
+    // Hogwild shares out the epochs of feedforward networks, when they pay for it, whole.
+    if (hogwild && net->schedule != NULL){
+	if (PAR_WORTH(batches * batchsize * (net->synapsecount + net->nodecount))) hogthreads = threads;
+	position = train_alloc(net->synapsecount, sizeof(unsigned int));
+	for (unsigned int place = 0; place < net->schedule->first[net->nodecount]; place++)
+	    position[net->schedule->synapses[place]] = place;
+    }
+    opt = optimizer_new(plan_optimizer(plan), net->synapsecount, plan->trainrate, plan->momentum, plan->decay);
+    if ((plan->workers > 1 || deterministic) && net->schedule == NULL)
+	fprintf(stderr, "A recurrent network depends on the order of its cases, and is trained by a single process.\n");
+    if (!shared_plan(net, plan)) group = NULL;
+    if (group != NULL){
+	slots = plan_slots(plan, batchsize);
+	shared = (flotype *)workers_data(group) + net->synapsecount;
+    }
+    // only the first process reports
+    if (plan->reportdest != NULL && (group == NULL || group->rank == 0) && NULL == (report = fopen(plan->reportdest, "w"))){
+	fprintf(stderr, "unable to open %s\n", plan->reportdest); exit(1);
+    }
+
+    for (epoch = 1; ; epoch++){
+	if (hogwild){
+	    sse = hogwild_epoch(net, examples, casecount, next, batchsize, batches, trainers, hogthreads, position, plan->trainrate);
+	    next = (next + batches * batchsize) % casecount;
+	}
+	else if (group != NULL) for (sse = ZERO, pos = 0; pos < batches; pos++){
+	    sse += workers_batch(net, examples, casecount, next, batchsize, trainers, threads, group, shared, slots, deterministic);
+	    next = (next + batchsize) % casecount;
+	    optimizer_step(opt, &(shared[slots * (net->synapsecount + 1)]), ONE / batchsize, net->weights);
+	    nnet_schedule_weights(net);
+	}
+	else for (sse = ZERO, pos = 0; pos < batches; pos++){
+	    sse += train_batch(net, examples, casecount, next, batchsize, trainers, threads);
+	    next = (next + batchsize) % casecount;
+	    gather_gradient(net, trainers, threads);
+	    optimizer_step(opt, trainers[0].gradient, ONE / batchsize, net->weights);
+	    memset(trainers[0].gradient, 0, sizeof(flotype) * net->synapsecount);
+	    nnet_schedule_weights(net);
+	}
+	accuracy = ONE - squareroot(sse / (batches * batchsize * net->outputcount));
+	if (report != NULL) fprintf(report, "epoch %u accuracy"FLOFMT"\n", epoch, accuracy);
+	if (epoch >= plan->epochmin && accuracy >= plan->goal) break;
+	if (plan->epochmax != 0 && epoch >= plan->epochmax) break;
+    }
+    if (group == NULL || group->rank == 0){
+	printf("Trained %u epochs of %zu cases (%.0f cases per second", epoch, batches * batchsize,
+	       (double)epoch * batches * batchsize / (omp_get_wtime() - start));
+	if (hogwild) printf(", %d Hogwild thread%s", hogthreads, hogthreads > 1 ? "s" : "");
+	if (group != NULL) printf(", %d worker process%s", group->active, group->active > 1 ? "es" : "");
+	printf("): accuracy"FLOFMT", goal"FLOFMT".\n", accuracy, plan->goal);
+    }
+
+    if (report != NULL) fclose(report);
+    for (int thread = 0; thread < threads; thread++){
+	free(trainers[thread].activations); free(trainers[thread].history); free(trainers[thread].delta);
+	free(trainers[thread].outputs);     free(trainers[thread].gradient);
+    }
+    free(trainers); free(examples); free(position); optimizer_free(opt);
+    return accuracy;
+}
+
+// the job of a plan for the worker processes: its place in script order, counting from one. Plans are listed latest
+// first, so that is the length of the list from it on.
+static int plan_job(const struct plans *plan){
+    int job = 0;
+    for (; plan != NULL; plan = plan->next) job++;
+    return job;
+}
+
+// plans are listed latest first, so carry out the rest of the list before this one. Testing, validation and deployment
+// plans are not carried out yet; they are only written back with the network. A plan of the worker processes starts
+// them from the weights of this one.
+static void runplan(struct nnet *net, const struct plans *plan, struct workers *group){
+    if (plan == NULL) return;
+    runplan(net, plan->next, group);
+    if ((plan->planflags & PLAN_TRAIN) == 0) return;
+    if (group != NULL && shared_plan(net, plan)){
+	memcpy(workers_data(group), net->weights, sizeof(flotype) * net->synapsecount);
+	workers_post(group, plan_job(plan), MAX(plan->workers, 1));
+	nnettrain(net, plan, group);
+    }
+    else nnettrain(net, plan, NULL);
+}
+
+// The worker processes are forked before any plan runs, while this process has no OpenMP threads yet (see
+// workers_start), as many as the plan that asks for the most, with shared memory enough for any plan. Between the plans
+// they take part in they sleep.
+void runplans(struct nnet *net){
+    assert(net != NULL);
+    const struct plans *plan;
+    struct workers *group = NULL;
+    size_t casecount = 0, slots = 0;
+    int count = 0, job;
+
+    for (const struct cases *data = net->data; data != NULL; data = data->next)
+	if (training_data(net, data)) casecount += data->entrycount;
+    for (plan = net->plan; plan != NULL; plan = plan->next)
+	if (shared_plan(net, plan)){
+	    count = MAX(count, (int)MAX(plan->workers, 1));
+	    slots = MAX(slots, plan_slots(plan, plan->batchsize != 0 ? plan->batchsize : casecount));
+	}
+    if (count > 0)
+	group = workers_start(count, sizeof(flotype) * (2 * (size_t)net->synapsecount + slots * (net->synapsecount + 1)));
+
+    if (group != NULL && group->rank != 0){
+	while ((job = workers_next(group)) != 0){
+	    for (plan = net->plan; plan_job(plan) != job; plan = plan->next);
+	    memcpy(net->weights, workers_data(group), sizeof(flotype) * net->synapsecount);
+	    nnet_schedule_weights(net);
+	    nnettrain(net, plan, group);
+	}
+	workers_finish(group);
+    }
+    runplan(net, net->plan, group);
+    if (group != NULL) workers_finish(group);
+}
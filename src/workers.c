@@ -0,0 +1,127 @@
+/* workers.c -- This belongs to gneural_network
+
+   gneural_network is the GNU package which implements a programmable neural network.
+
+   Copyright (C) 2017 gneural_network developers
+
+   This program is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software
+   Foundation; either version 3, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// worker processes on one host, and the barrier they meet at.
+
+#include "includes.h"
+#include "workers.h"
+
+// a barrier: 'arrived' counts the workers waiting at it, and the last to arrive starts the next generation, which
+// releases the others.
+struct barrier{
+    unsigned int arrived;
+    unsigned int generation;
+};
+
+// the start of the shared mapping: the barrier of the workers of a job, the one every worker meets at to get the next
+// job, and the job. The data follows, 64-byte aligned.
+struct control{
+    struct barrier job;
+    struct barrier all;
+    int next;
+    int active;
+};
+#define WORKERS_DATA 64
+#define WORKERS_NAP 1000000 /* nanoseconds a worker sleeps between looks while it waits for a job */
+
+static void workers_fail(const char *what){
+    fprintf(stderr, "Workers: %s\n", what); exit(1);
+}
+
+struct workers *workers_start(int count, size_t bytes){
+    struct workers *w = calloc(1, sizeof(struct workers));
+    if (w == NULL || count < 1) workers_fail("no memory available to start the worker processes.");
+    w->count = w->active = count;
+    w->size = WORKERS_DATA + bytes;
+    w->mapping = mmap(NULL, w->size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (w->mapping == MAP_FAILED) workers_fail("unable to map memory shared by the worker processes.");
+    w->pids = calloc(count, sizeof(pid_t));
+    if (w->pids == NULL) workers_fail("no memory available to start the worker processes.");
+    // anything still buffered would be written once by every process
+    fflush(NULL);
+    w->pids[0] = getpid();
+    for (int rank = 1; rank < count; rank++){
+	pid_t pid = fork();
+	if (pid < 0) workers_fail("unable to fork the worker processes.");
+	if (pid == 0) {w->rank = rank; return w;}
+	w->pids[rank] = pid;
+    }
+    return w;
+}
+
+void *workers_data(const struct workers *w){
+    return (char *)w->mapping + WORKERS_DATA;
+}
+
+// a worker that dies would leave the others waiting for ever: while it waits, worker 0 watches the others, and they
+// watch worker 0, and the group stops if any of them is gone.
+static void workers_check(const struct workers *w){
+    int status;
+    if (w->rank == 0){
+	for (int rank = 1; rank < w->count; rank++)
+	    if (waitpid(w->pids[rank], &status, WNOHANG) != 0) workers_fail("a worker process ended before the others.");
+    }
+    else if (getppid() != w->pids[0]) _exit(1);
+}
+
+// wait at barrier b until 'count' workers are there. Workers waiting for a job may wait as long as worker 0 trains
+// alone: they sleep between looks rather than spin.
+static void barrier_wait(const struct workers *w, struct barrier *b, int count, int sleepy){
+    const struct timespec nap = {0, WORKERS_NAP};
+    unsigned int generation = __atomic_load_n(&(b->generation), __ATOMIC_ACQUIRE);
+    if (count == 1) return;
+    if (__atomic_add_fetch(&(b->arrived), 1, __ATOMIC_ACQ_REL) == (unsigned int)count){
+	__atomic_store_n(&(b->arrived), 0, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&(b->generation), 1, __ATOMIC_RELEASE);
+	return;
+    }
+    for (unsigned long spin = 1; __atomic_load_n(&(b->generation), __ATOMIC_ACQUIRE) == generation; spin++){
+	if (sleepy && spin > 4096) nanosleep(&nap, NULL); else sched_yield();
+	if (spin % 4096 == 0) workers_check(w);
+    }
+}
+
+// the job is read between two barriers, so that worker 0 does not post the next one before every worker has it
+void workers_post(struct workers *w, int job, int active){
+    struct control *c = w->mapping;
+    c->next = job;
+    c->active = w->active = MAX(1, MIN(active, w->count));
+    barrier_wait(w, &(c->all), w->count, 0);
+    barrier_wait(w, &(c->all), w->count, 0);
+}
+
+int workers_next(struct workers *w){
+    struct control *c = w->mapping;
+    int job;
+    for (;;){
+	barrier_wait(w, &(c->all), w->count, 1);
+	job = c->next;
+	w->active = c->active;
+	barrier_wait(w, &(c->all), w->count, 0);
+	if (job == 0 || w->rank < w->active) return job;
+    }
+}
+
+void workers_barrier(struct workers *w){
+    barrier_wait(w, &(((struct control *)w->mapping)->job), w->active, 0);
+}
+
+void workers_finish(struct workers *w){
+    if (w->rank != 0) _exit(0);
+    workers_post(w, 0, w->count);
+    for (int rank = 1; rank < w->count; rank++) waitpid(w->pids[rank], NULL, 0);
+    munmap(w->mapping, w->size);
+    free(w->pids); free(w);
+}
@@ -0,0 +1,51 @@
+#!/bin/sh
+# workers.sh -- regression checks of the Workers training plans of nnet (see doc/nnet_language.1)
+#
+# usage: sh tests/workers.sh [nnet binary]    (default: src/nnet)
+#
+# - workers_two_plans.nnet, a plan of one process followed by one of worker processes, must end in time;
+# - workers_deterministic.nnet, trained with Workers 1 and with Workers 3, must write the same network.
+#
+# Every script runs with 4 OpenMP threads under a time limit, in a scratch directory. Prints FAIL lines and exits
+# non zero if any check fails. Networks are written with six digits unless nnet is built with all of them,
+#   ./configure CPPFLAGS=-DFLOFMT_ALL_BITS
+# which the comparisons of Deterministic training need to see every bit.
+
+NNET=$(cd "$(dirname "${1:-src/nnet}")" && pwd)/$(basename "${1:-src/nnet}")
+TESTS=$(cd "$(dirname "$0")" && pwd)
+SCRATCH=$(mktemp -d)
+STATUS=0
+trap 'rm -rf "$SCRATCH"' EXIT
+export OMP_NUM_THREADS=4
+cd "$SCRATCH" || exit 1
+
+fail(){
+    echo "FAIL: $1"; STATUS=1
+}
+
+# train script $1 (a name in the scratch directory, without .nnet); fails if nnet does not end in time
+train(){
+    timeout 120 "$NNET" "$1.nnet" > "$1.log" 2>&1 || fail "$1.nnet did not train (exit status $?)"
+}
+
+# the weights of a written network, without the plans, which name the number of workers
+weights(){
+    sed -e '/^StartPlan/,/^EndPlan/d' "$1.out"
+}
+
+cp "$TESTS/workers_two_plans.nnet" two_plans.nnet
+train two_plans
+[ "$(grep -c '^Trained' two_plans.log)" -eq 2 ] || fail "workers_two_plans.nnet did not carry out both plans"
+
+for count in 1 3; do
+    sed -e "s/Workers 3/Workers $count/" -e "s/workers_deterministic.rep/deterministic$count.rep/" \
+	"$TESTS/workers_deterministic.nnet" > "deterministic$count.nnet"
+    train "deterministic$count"
+done
+weights deterministic1 > deterministic1.weights
+weights deterministic3 > deterministic3.weights
+cmp -s deterministic1.weights deterministic3.weights || fail "Deterministic training differs with Workers 1 and Workers 3"
+cmp -s deterministic1.rep deterministic3.rep || fail "Deterministic accuracies differ with Workers 1 and Workers 3"
+
+[ $STATUS -eq 0 ] && echo "workers: all checks passed"
+exit $STATUS